@@ -0,0 +1,116 @@
+#include "AsyncFileWriter.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+#include <unistd.h>
+
+AsyncFileWriter::AsyncFileWriter() : ownerPid(getpid()), worker(&AsyncFileWriter::run, this) {}
+
+AsyncFileWriter::~AsyncFileWriter() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeWorker.notify_one();
+    worker.join();
+}
+
+AsyncFileWriter::Ticket AsyncFileWriter::NewTicket() {
+    return nextTicket++;
+}
+
+void AsyncFileWriter::Write(Ticket ticket, const std::string& path, std::vector<char> data) {
+    if (getpid() != ownerPid) {
+        Job job{ticket, path, std::move(data)};
+        if (!writeFile(job)) batches[ticket].failures.push_back(path);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++batches[ticket].pending;
+        queue.push_back({ticket, path, std::move(data)});
+    }
+    wakeWorker.notify_one();
+}
+
+std::vector<std::string> AsyncFileWriter::Flush(Ticket ticket) {
+    std::vector<std::string> failed;
+    if (getpid() != ownerPid) {
+        auto batch = batches.find(ticket);
+        if (batch == batches.end()) return failed;
+        failed.swap(batch->second.failures);
+        batches.erase(batch);
+        return failed;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    wakeFlush.wait(lock, [this, ticket] {
+        auto batch = batches.find(ticket);
+        return batch == batches.end() || batch->second.pending == 0;
+    });
+
+    auto batch = batches.find(ticket);
+    if (batch == batches.end()) return failed;
+    failed.swap(batch->second.failures);
+    batches.erase(batch);
+    return failed;
+}
+
+std::vector<std::string> AsyncFileWriter::FlushAll() {
+    std::unique_lock<std::mutex> lock(mutex, std::defer_lock);
+    if (getpid() == ownerPid) {
+        lock.lock();
+        wakeFlush.wait(lock, [this] {
+            return std::all_of(batches.begin(), batches.end(), [](const auto& batch) { return batch.second.pending == 0; });
+        });
+    }
+
+    std::vector<std::string> failed;
+    for (auto& batch : batches) {
+        failed.insert(failed.end(), batch.second.failures.begin(), batch.second.failures.end());
+    }
+    batches.clear();
+    return failed;
+}
+
+bool AsyncFileWriter::writeFile(const Job& job) {
+    // Written under a name no other process or write uses, and renamed once complete,
+    // so a reader never sees a partial file and concurrent writes to one path do not interleave
+    static std::atomic<unsigned long> tempCounter{0};
+    std::string tempPath = job.path + ".tmp" + std::to_string(getpid()) + "." + std::to_string(tempCounter++);
+
+    std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+    out.write(job.data.data(), job.data.size());
+    out.close();
+    if (out && std::rename(tempPath.c_str(), job.path.c_str()) == 0) return true;
+
+    std::remove(tempPath.c_str());
+    return false;
+}
+
+AsyncFileWriter& AsyncFileWriter::Shared() {
+    static AsyncFileWriter writer;
+    return writer;
+}
+
+void AsyncFileWriter::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wakeWorker.wait(lock, [this] { return stopping || !queue.empty(); });
+        if (queue.empty()) break;
+
+        Job job = std::move(queue.front());
+        queue.pop_front();
+        lock.unlock();
+
+        bool ok = writeFile(job);
+
+        lock.lock();
+        Batch& batch = batches[job.ticket];
+        if (!ok) batch.failures.push_back(job.path);
+        if (--batch.pending == 0) wakeFlush.notify_all();
+    }
+}
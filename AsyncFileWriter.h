@@ -0,0 +1,73 @@
+#ifndef ASYNC_FILE_WRITER_H
+#define ASYNC_FILE_WRITER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Writes encoded files to disk on a background thread, so the caller can move on
+// to building the next plot while the previous one is being written.
+class AsyncFileWriter {
+public:
+    // Constructor
+    AsyncFileWriter();
+    // Destructor, waits for all pending writes
+    ~AsyncFileWriter();
+
+    AsyncFileWriter(const AsyncFileWriter&) = delete;
+    AsyncFileWriter& operator=(const AsyncFileWriter&) = delete;
+
+    // Identifies the writes of one caller, who waits for and collects the failures of those writes only
+    using Ticket = unsigned long;
+    Ticket NewTicket();
+
+    // Queue a buffer to be written to path under ticket
+    void Write(Ticket ticket, const std::string& path, std::vector<char> data);
+
+    // Wait until every write queued under ticket has finished, returns the paths that failed.
+    // The ticket is released and must not be used afterwards.
+    std::vector<std::string> Flush(Ticket ticket);
+
+    // Wait until every queued write has finished, returns the paths that failed under any ticket and
+    // releases all tickets. Only for a process that owns every write, such as a batch worker about to exit.
+    std::vector<std::string> FlushAll();
+
+    // Writer shared by all Plotters in the process
+    static AsyncFileWriter& Shared();
+
+private:
+    struct Job {
+        Ticket ticket;
+        std::string path;
+        std::vector<char> data;
+    };
+
+    // Writes of one ticket that are still queued or running, and the paths that failed so far
+    struct Batch {
+        int pending = 0;
+        std::vector<std::string> failures;
+    };
+
+    std::mutex mutex;
+    std::condition_variable wakeWorker;
+    std::condition_variable wakeFlush;
+    std::deque<Job> queue;
+    std::map<Ticket, Batch> batches;
+    std::atomic<Ticket> nextTicket{1};
+    bool stopping = false;
+
+    // Process that owns the worker thread; a forked child has no worker and writes synchronously
+    int ownerPid;
+
+    std::thread worker;
+
+    void run();
+    static bool writeFile(const Job& job);
+};
+
+#endif
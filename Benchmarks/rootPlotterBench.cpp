@@ -0,0 +1,200 @@
+#include "rootPlotter.h"
+#include <TROOT.h>
+#include <TRandom3.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Times the main Plotter phases over a grid of object counts, point counts and object types,
+// and writes one CSV row per (type, objects, points, phase):
+//     type,objects,points,phase,repeats,min_ms,median_ms,max_ms
+//
+// Usage: rootPlotterBench [--output file.csv] [--repeats n] [--max-total n] [--image-dir dir] [--quick]
+// Configurations with more than --max-total points in total (default 10^8) are skipped.
+// Functions are sampled once per pixel column of the frame whatever the point count, so TF1 rows
+// are only timed once per object count, with points set to the canvas width.
+
+namespace {
+
+struct Options {
+    std::string output = "rootPlotterBench.csv";
+    std::string imageDir = ".";
+    int repeats = 3;
+    double maxTotal = 1e8;
+    bool quick = false;
+};
+
+double elapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+double timeMs(const std::function<void()>& phase) {
+    auto start = std::chrono::steady_clock::now();
+    phase();
+    return elapsedMs(start);
+}
+
+// Timings of one phase over all repeats
+struct PhaseTimes {
+    std::string phase;
+    std::vector<double> ms;
+};
+
+void writeRows(std::ofstream& out, const std::string& type, int objects, int points, std::vector<PhaseTimes>& phases) {
+    for (auto& times : phases) {
+        std::sort(times.ms.begin(), times.ms.end());
+        out << type << "," << objects << "," << points << "," << times.phase << "," << times.ms.size() << ","
+            << times.ms.front() << "," << times.ms[times.ms.size() / 2] << "," << times.ms.back() << "\n";
+    }
+    out.flush();
+}
+
+// Runs every phase on the given objects, which are borrowed so that they can be reused across repeats
+template <typename T>
+void runCase(Plotter& plotter, const std::string& type, const std::vector<T*>& objects, int points, const Options& options, std::ofstream& out) {
+    std::vector<PhaseTimes> phases = {{"AddObject", {}}, {"getAxisLimits", {}}, {"PlaceLegend", {}}, {"CreatePlot", {}}, {"SaveAs", {}}};
+    std::string image = options.imageDir + "/rootPlotterBench.png";
+
+    for (int repeat = 0; repeat < options.repeats; ++repeat) {
+        plotter.Reset();
+
+        phases[0].ms.push_back(timeMs([&] {
+            for (std::size_t i = 0; i < objects.size(); ++i) {
+                plotter.AddObject(objects[i], type + " " + std::to_string(i), true, true, "", Plotter::Ownership::Borrowed);
+            }
+        }));
+
+        // Cold limits, the cached bounds are dropped first
+        plotter.MarkModified();
+        phases[1].ms.push_back(timeMs([&] { plotter.GetAxisLimits(); }));
+        phases[2].ms.push_back(timeMs([&] { plotter.PlaceLegend(); }));
+        phases[3].ms.push_back(timeMs([&] { plotter.CreatePlot(); }));
+        phases[4].ms.push_back(timeMs([&] { plotter.SaveAs(image); }));
+    }
+
+    writeRows(out, type, static_cast<int>(objects.size()), points, phases);
+    plotter.Reset();
+}
+
+std::vector<TH1D*> makeHistograms(int count, int points, TRandom3& rand) {
+    std::vector<TH1D*> hists;
+    for (int i = 0; i < count; ++i) {
+        TH1D* hist = new TH1D(("bench_h" + std::to_string(i)).c_str(), "Benchmark", points, 0, 10);
+        for (int bin = 1; bin <= points; ++bin) {
+            double x = hist->GetBinCenter(bin);
+            hist->SetBinContent(bin, 100 * std::exp(-0.5 * (x - 5) * (x - 5)) + 10 * i + rand.Uniform(0, 5));
+        }
+        hists.push_back(hist);
+    }
+    return hists;
+}
+
+template <typename T>
+std::vector<T*> makeGraphs(int count, int points, TRandom3& rand) {
+    std::vector<T*> graphs;
+    std::vector<double> x(points), y(points), ex(points, 0.0), ey(points);
+    for (int i = 0; i < count; ++i) {
+        for (int p = 0; p < points; ++p) {
+            x[p] = 10.0 * p / points;
+            y[p] = 100 * std::sin(x[p]) + 50 * i + rand.Gaus(0, 5);
+            ey[p] = 5;
+        }
+        if constexpr (std::is_same_v<T, TGraphErrors>) {
+            graphs.push_back(new TGraphErrors(points, x.data(), y.data(), ex.data(), ey.data()));
+        } else {
+            graphs.push_back(new T(points, x.data(), y.data()));
+        }
+    }
+    return graphs;
+}
+
+std::vector<TF1*> makeFunctions(int count) {
+    std::vector<TF1*> funcs;
+    for (int i = 0; i < count; ++i) {
+        TF1* func = new TF1(("bench_f" + std::to_string(i)).c_str(), "[0]*sin(x)+[1]", 0, 10);
+        func->SetParameters(100, 50 * i);
+        funcs.push_back(func);
+    }
+    return funcs;
+}
+
+template <typename T>
+void deleteAll(std::vector<T*>& objects) {
+    for (T* obj : objects) delete obj;
+    objects.clear();
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--output" && hasValue) options.output = argv[++i];
+        else if (arg == "--image-dir" && hasValue) options.imageDir = argv[++i];
+        else if (arg == "--repeats" && hasValue) options.repeats = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--max-total" && hasValue) options.maxTotal = std::atof(argv[++i]);
+        else if (arg == "--quick") options.quick = true;
+        else {
+            std::cerr << "Usage: " << argv[0] << " [--output file.csv] [--repeats n] [--max-total n] [--image-dir dir] [--quick]" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) return 1;
+
+    gROOT->SetBatch(kTRUE);
+    TH1::AddDirectory(kFALSE);
+
+    std::ofstream out(options.output);
+    if (!out) {
+        std::cerr << "Error: cannot open " << options.output << std::endl;
+        return 1;
+    }
+    out << "type,objects,points,phase,repeats,min_ms,median_ms,max_ms\n";
+
+    std::vector<int> objectCounts = options.quick ? std::vector<int>{1, 10} : std::vector<int>{1, 10, 100};
+    std::vector<int> pointCounts = options.quick ? std::vector<int>{100, 10000} : std::vector<int>{100, 1000, 10000, 100000, 1000000, 10000000};
+
+    // One canvas for the whole run, recycled with Reset()
+    Plotter plotter("bench", "Benchmark");
+    TRandom3 rand(12345);
+
+    for (int objects : objectCounts) {
+        for (int points : pointCounts) {
+            if (static_cast<double>(objects) * points > options.maxTotal) continue;
+            std::cout << objects << " objects x " << points << " points" << std::endl;
+
+            auto hists = makeHistograms(objects, points, rand);
+            runCase(plotter, "TH1D", hists, points, options, out);
+            deleteAll(hists);
+
+            auto graphs = makeGraphs<TGraph>(objects, points, rand);
+            runCase(plotter, "TGraph", graphs, points, options, out);
+            deleteAll(graphs);
+
+            auto graphErrors = makeGraphs<TGraphErrors>(objects, points, rand);
+            runCase(plotter, "TGraphErrors", graphErrors, points, options, out);
+            deleteAll(graphErrors);
+        }
+
+        auto funcs = makeFunctions(objects);
+        runCase(plotter, "TF1", funcs, static_cast<int>(plotter.GetPlot()->GetWw()), options, out);
+        deleteAll(funcs);
+    }
+
+    std::cout << "Results written to " << options.output << std::endl;
+    return 0;
+}
@@ -0,0 +1,49 @@
+#include "ColorCache.h"
+
+#include <TColor.h>
+
+#include <cctype>
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <utility>
+
+namespace {
+
+std::mutex& cacheMutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+} // namespace
+
+int InternTransparentColor(int color, double alpha) {
+    int milli = static_cast<int>(std::lround(alpha * 1000));
+    if (milli >= 1000) return color;
+    if (milli < 0) milli = 0;
+
+    std::lock_guard<std::mutex> lock(cacheMutex());
+    static std::map<std::pair<int, int>, int> transparent;
+    auto found = transparent.find({color, milli});
+    if (found != transparent.end()) return found->second;
+
+    int index = TColor::GetColorTransparent(color, milli / 1000.0f);
+    transparent.emplace(std::make_pair(color, milli), index);
+    return index;
+}
+
+int InternHexColor(const std::string& hex) {
+    if (hex.size() != 7 || hex[0] != '#') return -1;
+    for (std::size_t i = 1; i < hex.size(); ++i) {
+        if (!std::isxdigit(static_cast<unsigned char>(hex[i]))) return -1;
+    }
+
+    std::lock_guard<std::mutex> lock(cacheMutex());
+    static std::map<std::string, int> colors;
+    auto found = colors.find(hex);
+    if (found != colors.end()) return found->second;
+
+    int index = TColor::GetColor(hex.c_str());
+    colors.emplace(hex, index);
+    return index;
+}
@@ -0,0 +1,17 @@
+#ifndef COLOR_CACHE_H
+#define COLOR_CACHE_H
+
+#include <string>
+
+// Process-wide interning of the ROOT colors created by plotters. ROOT allocates a new TColor for
+// every transparent variant it is asked for, so each one is created once and its index reused by
+// every plot. Safe to call from several threads.
+
+// Index of color with the given alpha, the color itself when alpha >= 1.
+// Alpha is rounded to 1/1000, which is finer than any output can show.
+int InternTransparentColor(int color, double alpha);
+
+// Index of a "#rrggbb" color, -1 if the string is not a valid hex color
+int InternHexColor(const std::string& hex);
+
+#endif
@@ -0,0 +1,124 @@
+#include "ContentHash.h"
+
+#include <TH1.h>
+#include <TGraph.h>
+#include <TF1.h>
+#include <TEfficiency.h>
+#include <TAttLine.h>
+#include <TAttFill.h>
+#include <TAttMarker.h>
+#include <TColor.h>
+#include <TROOT.h>
+
+#include <cstdio>
+
+void ContentHash::Add(const void* data, std::size_t size) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (std::size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+}
+
+void ContentHash::Add(const std::string& text) {
+    Add(static_cast<long long>(text.size()));
+    Add(text.data(), text.size());
+}
+
+void ContentHash::AddContents(const TH1* hist) {
+    Add(hist->ClassName());
+    Add(hist->GetTitle());
+    Add(hist->GetXaxis()->GetTitle());
+    Add(hist->GetYaxis()->GetTitle());
+
+    // Binning, visible range and every bin including under- and overflow
+    const TAxis* axis = hist->GetXaxis();
+    int nBins = hist->GetNbinsX();
+    Add(nBins);
+    Add(axis->GetFirst());
+    Add(axis->GetLast());
+    for (int bin = 1; bin <= nBins + 1; ++bin) Add(axis->GetBinLowEdge(bin));
+    for (int bin = 0; bin <= nBins + 1; ++bin) {
+        Add(hist->GetBinContent(bin));
+        Add(hist->GetBinError(bin));
+    }
+
+    // Everything the stats box can show
+    double stats[13] = {};
+    hist->GetStats(stats);
+    Add(stats, sizeof(stats));
+    Add(hist->GetEntries());
+}
+
+void ContentHash::AddContents(const TGraph* graph) {
+    Add(graph->ClassName());
+    Add(graph->GetTitle());
+
+    int n = graph->GetN();
+    Add(n);
+    auto addArray = [&](const double* values) {
+        Add(values != nullptr);
+        if (values) Add(values, n * sizeof(double));
+    };
+    addArray(graph->GetX());
+    addArray(graph->GetY());
+    addArray(graph->GetEX());
+    addArray(graph->GetEY());
+    addArray(graph->GetEXlow());
+    addArray(graph->GetEXhigh());
+    addArray(graph->GetEYlow());
+    addArray(graph->GetEYhigh());
+}
+
+void ContentHash::AddContents(const TF1* func) {
+    Add(func->ClassName());
+    Add(func->GetTitle());
+    Add(func->GetExpFormula().Data());
+    Add(func->GetXmin());
+    Add(func->GetXmax());
+    Add(func->GetNpar());
+    for (int i = 0; i < func->GetNpar(); ++i) Add(func->GetParameter(i));
+}
+
+void ContentHash::AddContents(const TEfficiency* eff) {
+    Add(eff->ClassName());
+    Add(eff->GetTitle());
+    AddContents(eff->GetPassedHistogram());
+    AddContents(eff->GetTotalHistogram());
+}
+
+void ContentHash::AddAttributes(const TObject* obj) {
+    if (auto line = dynamic_cast<const TAttLine*>(obj)) {
+        AddColor(line->GetLineColor());
+        Add(static_cast<int>(line->GetLineWidth()));
+        Add(static_cast<int>(line->GetLineStyle()));
+    }
+    if (auto fill = dynamic_cast<const TAttFill*>(obj)) {
+        AddColor(fill->GetFillColor());
+        Add(static_cast<int>(fill->GetFillStyle()));
+    }
+    if (auto marker = dynamic_cast<const TAttMarker*>(obj)) {
+        AddColor(marker->GetMarkerColor());
+        Add(static_cast<int>(marker->GetMarkerStyle()));
+        Add(static_cast<double>(marker->GetMarkerSize()));
+    }
+}
+
+void ContentHash::AddColor(int index) {
+    const TColor* color = gROOT->GetColor(index);
+    Add(color != nullptr);
+    if (!color) {
+        Add(index);
+        return;
+    }
+    Add(static_cast<double>(color->GetRed()));
+    Add(static_cast<double>(color->GetGreen()));
+    Add(static_cast<double>(color->GetBlue()));
+    Add(static_cast<double>(color->GetAlpha()));
+}
+
+std::string ContentHash::Hex() const {
+    char buffer[17];
+    std::snprintf(buffer, sizeof(buffer), "%016llx", static_cast<unsigned long long>(hash));
+    return buffer;
+}
@@ -0,0 +1,46 @@
+#ifndef CONTENT_HASH_H
+#define CONTENT_HASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+class TObject;
+class TH1;
+class TGraph;
+class TF1;
+class TEfficiency;
+
+// 64-bit FNV-1a hash of plot inputs. Values are hashed by their bytes, so a hash is stable
+// between runs and processes of the same build but not meant to be portable between platforms.
+class ContentHash {
+public:
+    void Add(const void* data, std::size_t size);
+    void Add(double value) { Add(&value, sizeof(value)); }
+    void Add(long long value) { Add(&value, sizeof(value)); }
+    void Add(int value) { Add(static_cast<long long>(value)); }
+    void Add(bool value) { Add(static_cast<long long>(value)); }
+    // Strings are length-prefixed so that consecutive strings cannot run into each other
+    void Add(const std::string& text);
+    void Add(const char* text) { Add(std::string(text ? text : "")); }
+
+    // Contents of the supported objects, including titles and axis titles
+    void AddContents(const TH1* hist);
+    void AddContents(const TGraph* graph);
+    void AddContents(const TF1* func);
+    void AddContents(const TEfficiency* eff);
+
+    // Line, fill and marker attributes of an object that has them, with colors hashed by AddColor
+    void AddAttributes(const TObject* obj);
+    // RGBA of a color index, since transparent and palette colors get their indices in creation order
+    void AddColor(int index);
+
+    std::uint64_t Value() const { return hash; }
+    // Value as 16 hexadecimal digits, usable in file names
+    std::string Hex() const;
+
+private:
+    std::uint64_t hash = 14695981039346656037ull;
+};
+
+#endif
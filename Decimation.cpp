@@ -0,0 +1,96 @@
+#include "Decimation.h"
+
+#include <algorithm>
+#include <cmath>
+
+bool IsSorted(const double* x, int n) {
+    for (int i = 1; i < n; ++i) {
+        if (x[i] < x[i - 1]) return false;
+    }
+    return true;
+}
+
+std::vector<int> DecimateMinMax(const double* x, const double* y, int n, int columns) {
+    std::vector<int> kept;
+    if (n <= 0) return kept;
+
+    double xmin = x[0];
+    double xmax = x[n - 1];
+    double scale = (xmax > xmin) ? columns / (xmax - xmin) : 0;
+
+    kept.reserve(4 * columns + 4);
+
+    int i = 0;
+    while (i < n) {
+        int column = std::min(static_cast<int>((x[i] - xmin) * scale), columns - 1);
+        int first = i;
+        int lowest = i;
+        int highest = i;
+
+        // Points of one column are contiguous because x is sorted
+        while (i < n && std::min(static_cast<int>((x[i] - xmin) * scale), columns - 1) == column) {
+            if (y[i] < y[lowest]) lowest = i;
+            if (y[i] > y[highest]) highest = i;
+            ++i;
+        }
+        int last = i - 1;
+
+        int candidates[4] = {first, std::min(lowest, highest), std::max(lowest, highest), last};
+        for (int candidate : candidates) {
+            if (kept.empty() || kept.back() != candidate) kept.push_back(candidate);
+        }
+    }
+
+    return kept;
+}
+
+std::vector<int> DecimateLTTB(const double* x, const double* y, int n, int nPoints) {
+    std::vector<int> kept;
+    if (nPoints >= n || nPoints < 3) {
+        kept.resize(n);
+        for (int i = 0; i < n; ++i) kept[i] = i;
+        return kept;
+    }
+
+    kept.reserve(nPoints);
+    kept.push_back(0);
+
+    // Interior points are split into nPoints - 2 buckets, one point is kept per bucket
+    double bucketSize = static_cast<double>(n - 2) / (nPoints - 2);
+    int previous = 0;
+
+    for (int bucket = 0; bucket < nPoints - 2; ++bucket) {
+        int start = static_cast<int>(std::floor(bucket * bucketSize)) + 1;
+        int end = static_cast<int>(std::floor((bucket + 1) * bucketSize)) + 1;
+
+        // Average of the next bucket is the third vertex of the triangle
+        int nextStart = end;
+        int nextEnd = std::min(static_cast<int>(std::floor((bucket + 2) * bucketSize)) + 1, n);
+        double averageX = 0;
+        double averageY = 0;
+        for (int j = nextStart; j < nextEnd; ++j) {
+            averageX += x[j];
+            averageY += y[j];
+        }
+        int nextCount = std::max(nextEnd - nextStart, 1);
+        averageX /= nextCount;
+        averageY /= nextCount;
+
+        // Keep the point of this bucket spanning the largest triangle with the previous kept point
+        double largestArea = -1;
+        int chosen = start;
+        for (int j = start; j < end; ++j) {
+            double area = std::abs((x[previous] - averageX) * (y[j] - y[previous]) - (x[previous] - x[j]) * (averageY - y[previous]));
+            if (area > largestArea) {
+                largestArea = area;
+                chosen = j;
+            }
+        }
+
+        kept.push_back(chosen);
+        previous = chosen;
+    }
+
+    kept.push_back(n - 1);
+    return kept;
+}
@@ -0,0 +1,20 @@
+#ifndef DECIMATION_H
+#define DECIMATION_H
+
+#include <vector>
+
+// Reduction of large series to the points that are visible at a given pixel width.
+// Both methods return the indices of the points to keep, in increasing order, so
+// per-point data such as error bars can be carried over to the reduced series.
+
+// True if x is non-decreasing, which both methods require
+bool IsSorted(const double* x, int n);
+
+// Keeps the first, last, lowest and highest point of every pixel column, which
+// reproduces the drawn line exactly while keeping at most four points per column
+std::vector<int> DecimateMinMax(const double* x, const double* y, int n, int columns);
+
+// Largest-Triangle-Three-Buckets: keeps the nPoints points that best preserve the shape
+std::vector<int> DecimateLTTB(const double* x, const double* y, int n, int nPoints);
+
+#endif
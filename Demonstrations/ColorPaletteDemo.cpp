@@ -51,7 +51,7 @@ int main() {
     std::cout << "Plot created." << std::endl;
 
     // Save the canvas
-    plotter.GetPlot()->SaveAs("../Demonstrations/ColorPaletteDemo.png");
+    plotter.SaveAs("../Demonstrations/ColorPaletteDemo.png");
 
     std::cout << "Plot saved." << std::endl;
 
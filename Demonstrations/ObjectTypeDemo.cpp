@@ -64,7 +64,7 @@ int main() {
     plotter.CreatePlot();
 
     // Save the canvas
-    plotter.GetPlot()->SaveAs("../Demonstrations/ObjectTypeDemo.png");
+    plotter.SaveAs("../Demonstrations/ObjectTypeDemo.png");
 
     return 0;
 }
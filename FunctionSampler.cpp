@@ -0,0 +1,106 @@
+#include "FunctionSampler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+struct Point {
+    double x;
+    double y;
+};
+
+// Distance in pixels of b from the straight line through a and c
+double deviation(const Point& a, const Point& b, const Point& c, double pixelsPerY) {
+    double line = a.y + (c.y - a.y) * (b.x - a.x) / (c.x - a.x);
+    return std::abs(b.y - line) * pixelsPerY;
+}
+
+// Whether the interval between points[i] and points[i + 1] should be split
+bool needsSplit(const std::vector<Point>& points, std::size_t i, double pixelsPerY) {
+    const Point& a = points[i];
+    const Point& b = points[i + 1];
+    bool finiteA = std::isfinite(a.y);
+    bool finiteB = std::isfinite(b.y);
+
+    // Locate the edge of a region where the function is not finite, but do not sample inside it
+    if (finiteA != finiteB) return true;
+    if (!finiteA) return false;
+
+    // The curvature at either end, judged from its neighbours, exceeds half a pixel
+    if (i > 0 && std::isfinite(points[i - 1].y) && deviation(points[i - 1], a, b, pixelsPerY) > 0.5) return true;
+    if (i + 2 < points.size() && std::isfinite(points[i + 2].y) && deviation(a, b, points[i + 2], pixelsPerY) > 0.5) return true;
+    return false;
+}
+
+}
+
+void SampleFunction(const TF1* func, double xmin, double xmax, int columns, int rows, int maxPoints,
+                    std::vector<double>& x, std::vector<double>& y) {
+    x.clear();
+    y.clear();
+    columns = std::max(columns, 1);
+    rows = std::max(rows, 1);
+    maxPoints = std::max(maxPoints, 2);
+
+    // Uniform pass of one sample per pixel column, also used to estimate the pixel size in y
+    int nUniform = std::min(columns, maxPoints - 1);
+    double step = (xmax - xmin) / nUniform;
+    std::vector<Point> points(nUniform + 1);
+
+    double ymin = std::numeric_limits<double>::max();
+    double ymax = std::numeric_limits<double>::lowest();
+    for (int i = 0; i <= nUniform; ++i) {
+        double at = (i == nUniform) ? xmax : xmin + i * step;
+        points[i] = {at, func->Eval(at)};
+        if (!std::isfinite(points[i].y)) continue;
+        ymin = std::min(ymin, points[i].y);
+        ymax = std::max(ymax, points[i].y);
+    }
+    double pixelsPerY = rows / ((ymax > ymin) ? ymax - ymin : 1.0);
+
+    // Refine breadth-first: each pass halves every interval that still bends by more than half a pixel,
+    // down to a sixteenth of a column, until maxPoints evaluations are spent. When a pass wants more
+    // than the remaining budget, the splits are spread evenly over the candidates so no part of the
+    // range is favoured.
+    double minWidth = (xmax - xmin) / columns / 16;
+    std::size_t budget = maxPoints - (nUniform + 1);
+    std::vector<std::size_t> splits;
+    std::vector<Point> refined;
+    while (budget > 0) {
+        splits.clear();
+        for (std::size_t i = 0; i + 1 < points.size(); ++i) {
+            if (points[i + 1].x - points[i].x <= minWidth) continue;
+            if (needsSplit(points, i, pixelsPerY)) splits.push_back(i);
+        }
+        if (splits.empty()) break;
+
+        if (splits.size() > budget) {
+            for (std::size_t k = 0; k < budget; ++k) splits[k] = splits[k * splits.size() / budget];
+            splits.resize(budget);
+        }
+        budget -= splits.size();
+
+        refined.clear();
+        refined.reserve(points.size() + splits.size());
+        std::size_t next = 0;
+        for (std::size_t i = 0; i < points.size(); ++i) {
+            refined.push_back(points[i]);
+            if (next < splits.size() && splits[next] == i) {
+                double m = (points[i].x + points[i + 1].x) / 2;
+                refined.push_back({m, func->Eval(m)});
+                ++next;
+            }
+        }
+        points.swap(refined);
+    }
+
+    x.reserve(points.size());
+    y.reserve(points.size());
+    for (const Point& point : points) {
+        if (!std::isfinite(point.y)) continue;
+        x.push_back(point.x);
+        y.push_back(point.y);
+    }
+}
@@ -0,0 +1,15 @@
+#ifndef FUNCTION_SAMPLER_H
+#define FUNCTION_SAMPLER_H
+
+#include <TF1.h>
+
+#include <vector>
+
+// Samples func on [xmin, xmax] for a frame of columns x rows pixels. Starting from one sample per
+// pixel column, intervals are halved breadth-first only where the curve bends by more than half a
+// pixel, down to a sixteenth of a column. At most maxPoints evaluations are made in total.
+// Non-finite values are dropped from the output.
+void SampleFunction(const TF1* func, double xmin, double xmax, int columns, int rows, int maxPoints,
+                    std::vector<double>& x, std::vector<double>& y);
+
+#endif
@@ -0,0 +1,123 @@
+#include "OccupancyGrid.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+OccupancyGrid::OccupancyGrid(int nx, int ny)
+    : nx(nx), ny(ny), cells(nx * ny, 0),
+      columnHigh(nx, std::numeric_limits<double>::lowest()), columnLow(nx, std::numeric_limits<double>::max()),
+      table((nx + 1) * (ny + 1), 0) {}
+
+int OccupancyGrid::column(double x) const {
+    int col = static_cast<int>(std::floor(x * nx));
+    return std::clamp(col, 0, nx - 1);
+}
+
+int OccupancyGrid::row(double y) const {
+    int r = static_cast<int>(std::floor(y * ny));
+    return std::clamp(r, 0, ny - 1);
+}
+
+void OccupancyGrid::Clear() {
+    std::fill(cells.begin(), cells.end(), 0);
+    std::fill(columnHigh.begin(), columnHigh.end(), std::numeric_limits<double>::lowest());
+    std::fill(columnLow.begin(), columnLow.end(), std::numeric_limits<double>::max());
+    std::fill(table.begin(), table.end(), 0);
+}
+
+void OccupancyGrid::markColumn(int col, double y1, double y2) {
+    if (y1 > y2) std::swap(y1, y2);
+
+    columnHigh[col] = std::max(columnHigh[col], y2);
+    columnLow[col] = std::min(columnLow[col], y1);
+
+    // Content entirely outside the canvas is not drawn
+    if (y2 < 0 || y1 > 1) return;
+
+    int r1 = row(y1);
+    int r2 = row(y2);
+    for (int r = r1; r <= r2; ++r) {
+        cells[r * nx + col] = 1;
+    }
+}
+
+void OccupancyGrid::MarkPoint(double x, double y) {
+    MarkSpan(x, y, y);
+}
+
+void OccupancyGrid::MarkSpan(double x, double y1, double y2) {
+    if (!std::isfinite(x) || !std::isfinite(y1) || !std::isfinite(y2)) return;
+    if (x < 0 || x > 1) return;
+
+    markColumn(column(x), y1, y2);
+}
+
+void OccupancyGrid::MarkSegment(double x1, double y1, double x2, double y2) {
+    if (!std::isfinite(x1) || !std::isfinite(y1) || !std::isfinite(x2) || !std::isfinite(y2)) return;
+
+    if (x1 > x2) {
+        std::swap(x1, x2);
+        std::swap(y1, y2);
+    }
+    if (x2 < 0 || x1 > 1) return;
+
+    int c1 = column(x1);
+    int c2 = column(x2);
+    if (c1 == c2) {
+        markColumn(c1, y1, y2);
+        return;
+    }
+
+    // Walk the columns crossed by the segment and mark the y extent inside each one
+    double slope = (y2 - y1) / (x2 - x1);
+    for (int c = c1; c <= c2; ++c) {
+        double cx1 = std::max(x1, static_cast<double>(c) / nx);
+        double cx2 = std::min(x2, static_cast<double>(c + 1) / nx);
+        markColumn(c, y1 + slope * (cx1 - x1), y1 + slope * (cx2 - x1));
+    }
+}
+
+void OccupancyGrid::Build() {
+    int stride = nx + 1;
+    for (int r = 0; r < ny; ++r) {
+        int rowSum = 0;
+        for (int c = 0; c < nx; ++c) {
+            rowSum += cells[r * nx + c];
+            table[(r + 1) * stride + (c + 1)] = table[r * stride + (c + 1)] + rowSum;
+        }
+    }
+}
+
+int OccupancyGrid::Count(double xmin, double xmax, double ymin, double ymax) const {
+    if (xmin > xmax) std::swap(xmin, xmax);
+    if (ymin > ymax) std::swap(ymin, ymax);
+
+    int c1 = column(xmin);
+    int c2 = column(xmax) + 1;
+    int r1 = row(ymin);
+    int r2 = row(ymax) + 1;
+
+    int stride = nx + 1;
+    return table[r2 * stride + c2] - table[r1 * stride + c2] - table[r2 * stride + c1] + table[r1 * stride + c1];
+}
+
+double OccupancyGrid::HighestInColumns(double xmin, double xmax) const {
+    if (xmin > xmax) std::swap(xmin, xmax);
+
+    double highest = std::numeric_limits<double>::lowest();
+    for (int c = column(xmin); c <= column(xmax); ++c) {
+        highest = std::max(highest, columnHigh[c]);
+    }
+    return highest;
+}
+
+double OccupancyGrid::LowestInColumns(double xmin, double xmax) const {
+    if (xmin > xmax) std::swap(xmin, xmax);
+
+    double lowest = std::numeric_limits<double>::max();
+    for (int c = column(xmin); c <= column(xmax); ++c) {
+        lowest = std::min(lowest, columnLow[c]);
+    }
+    return lowest;
+}
@@ -0,0 +1,52 @@
+#ifndef OCCUPANCY_GRID_H
+#define OCCUPANCY_GRID_H
+
+#include <vector>
+
+// Coarse raster of the canvas in NDC coordinates. Drawn content is marked once,
+// then a summed-area table answers "is anything inside this box?" in O(1).
+class OccupancyGrid {
+public:
+    // Constructor
+    OccupancyGrid(int nx = 256, int ny = 256);
+
+    // Methods to mark content (all coordinates in NDC)
+    void Clear();
+    void MarkPoint(double x, double y);
+    void MarkSpan(double x, double y1, double y2);
+    void MarkSegment(double x1, double y1, double x2, double y2);
+
+    // Build the summed-area table, must be called after marking and before querying
+    void Build();
+
+    // Methods to query rectangles (all coordinates in NDC)
+    int Count(double xmin, double xmax, double ymin, double ymax) const;
+    bool IsOccupied(double xmin, double xmax, double ymin, double ymax) const { return Count(xmin, xmax, ymin, ymax) > 0; }
+
+    // Highest and lowest marked y in the columns spanning [xmin, xmax], lowest()/max() if none
+    double HighestInColumns(double xmin, double xmax) const;
+    double LowestInColumns(double xmin, double xmax) const;
+
+    int GetNx() const { return nx; }
+    int GetNy() const { return ny; }
+
+private:
+    int nx;
+    int ny;
+
+    // Occupied flags, row major with nx columns
+    std::vector<unsigned char> cells;
+
+    // Extreme marked y per column, kept unclamped so headroom can be computed exactly
+    std::vector<double> columnHigh;
+    std::vector<double> columnLow;
+
+    // Summed-area table, (nx+1) x (ny+1) with a zero first row and column
+    std::vector<int> table;
+
+    int column(double x) const;
+    int row(double y) const;
+    void markColumn(int col, double y1, double y2);
+};
+
+#endif
@@ -0,0 +1,79 @@
+#include "PdfDeck.h"
+#include "rootPlotter.h"
+
+#include <TCanvas.h>
+#include <TPaveText.h>
+
+#include <algorithm>
+#include <iostream>
+
+namespace {
+
+// Entries listed on each table of contents page, below its heading
+constexpr std::size_t kContentsPerPage = 30;
+
+}
+
+PdfDeck::PdfDeck(const std::string& filename, bool tableOfContents) : filename(filename), tableOfContents(tableOfContents) {}
+
+PdfDeck::~PdfDeck() {
+    Close();
+    delete canvas;
+}
+
+void PdfDeck::openFile(const TCanvas* firstPage) {
+    canvas = new TCanvas(("deck_" + filename).c_str(), filename.c_str(), firstPage->GetWw(), firstPage->GetWh());
+    canvas->Print((filename + "[").c_str(), "pdf");
+    open = true;
+}
+
+void PdfDeck::AddPage(Plotter& plotter, const std::string& title) {
+    if (closed) {
+        std::cerr << "Error: cannot add a page to " << filename << " after it was closed" << std::endl;
+        return;
+    }
+    if (!open) openFile(plotter.GetPlot());
+
+    std::string pageTitle = title.empty() ? plotter.GetTitle() : title;
+    if (pageTitle.empty()) pageTitle = "Page " + std::to_string(titles.size() + 1);
+    titles.push_back(pageTitle);
+
+    // "Title:" names the page in the PDF outline
+    plotter.GetPlot()->Print(filename.c_str(), ("Title:" + pageTitle).c_str());
+}
+
+void PdfDeck::Close() {
+    if (closed) return;
+    closed = true;
+    if (!open) return;
+
+    if (tableOfContents && !titles.empty()) {
+        // Lines are spaced the same on every page, so a last page with fewer entries is not spread out
+        double lineHeight = 0.9 / (kContentsPerPage + 1);
+        std::size_t nPages = (titles.size() + kContentsPerPage - 1) / kContentsPerPage;
+        for (std::size_t page = 0; page < nPages; ++page) {
+            std::size_t first = page * kContentsPerPage;
+            std::size_t last = std::min(first + kContentsPerPage, titles.size());
+            std::string heading = (page == 0) ? "Contents" : "Contents (" + std::to_string(page + 1) + ")";
+
+            canvas->cd();
+            canvas->Clear();
+
+            TPaveText contents(0.05, 0.95 - lineHeight * (last - first + 1), 0.95, 0.95, "NDC");
+            contents.SetFillColor(0);
+            contents.SetBorderSize(0);
+            contents.SetTextAlign(12);
+            contents.SetTextFont(42);
+            contents.SetTextSize(0.6 * lineHeight);
+            contents.AddText(heading.c_str());
+            for (std::size_t i = first; i < last; ++i) {
+                contents.AddText((std::to_string(i + 1) + "   " + titles[i]).c_str());
+            }
+            contents.Draw();
+            canvas->Print(filename.c_str(), ("Title:" + heading).c_str());
+        }
+        canvas->Clear();
+    }
+
+    canvas->Print((filename + "]").c_str(), "pdf");
+}
@@ -0,0 +1,46 @@
+#ifndef PDF_DECK_H
+#define PDF_DECK_H
+
+#include <string>
+#include <vector>
+
+class Plotter;
+class TCanvas;
+
+// Streams plots as the pages of a single PDF file, opened on the first page and closed once by Close().
+// Every page gets an entry in the PDF outline named after the plot title, and an optional
+// table of contents listing all titles is added at the end, over as many pages as it needs.
+// ROOT keeps a single PDF file open per process, so only one deck can be written at a time.
+class PdfDeck {
+public:
+    // Constructor
+    PdfDeck(const std::string& filename, bool tableOfContents = false);
+    // Destructor, closes the file if Close() was not called
+    ~PdfDeck();
+
+    PdfDeck(const PdfDeck&) = delete;
+    PdfDeck& operator=(const PdfDeck&) = delete;
+
+    // Add the current plot of a plotter as the next page, CreatePlot() must have been called.
+    // An empty title uses the plotter's title.
+    void AddPage(Plotter& plotter, const std::string& title = "");
+
+    // Write the table of contents if requested and close the file
+    void Close();
+
+    int GetNumPages() const { return titles.size(); }
+
+private:
+    std::string filename;
+    bool tableOfContents;
+    bool open = false;
+    bool closed = false;
+    std::vector<std::string> titles;
+
+    // Canvas that opens and closes the file and holds the table of contents, the size of the first page
+    TCanvas* canvas = nullptr;
+
+    void openFile(const TCanvas* firstPage);
+};
+
+#endif
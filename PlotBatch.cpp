@@ -0,0 +1,181 @@
+#include "PlotBatch.h"
+
+#include <TROOT.h>
+
+#include "AsyncFileWriter.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <map>
+#include <thread>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+// Keep messages well below the pipe buffer so a worker never blocks writing before it exits
+const std::size_t maxMessageSize = 4096;
+
+// Runs inside the forked worker; never returns
+[[noreturn]] void runWorker(const std::function<void()>& job, int fd) {
+    gROOT->SetBatch(kTRUE);
+
+    int status = 0;
+    std::string message;
+    try {
+        job();
+    } catch (const std::exception& e) {
+        status = 1;
+        message = e.what();
+    } catch (...) {
+        status = 1;
+        message = "unknown exception";
+    }
+
+    // Background writes must land before the worker exits
+    std::vector<std::string> failed = AsyncFileWriter::Shared().FlushAll();
+    for (const auto& path : failed) {
+        status = 1;
+        message += (message.empty() ? "" : "\n") + ("failed to write " + path);
+    }
+
+    if (message.size() > maxMessageSize) message.resize(maxMessageSize);
+    if (!message.empty() && write(fd, message.data(), message.size()) < 0) status = 1;
+    close(fd);
+
+    std::fflush(stdout);
+    std::fflush(stderr);
+    _exit(status);
+}
+
+std::string readMessage(int fd) {
+    std::string message;
+    char buffer[512];
+    ssize_t n;
+    while ((n = read(fd, buffer, sizeof(buffer))) > 0) {
+        message.append(buffer, n);
+    }
+    return message;
+}
+
+}
+
+PlotBatch::PlotBatch(int workers) : nWorkers(workers) {
+    if (nWorkers <= 0) {
+        nWorkers = std::max(1u, std::thread::hardware_concurrency());
+    }
+}
+
+void PlotBatch::AddJob(const std::string& name, std::function<void()> job) {
+    jobs.push_back({name, std::move(job)});
+}
+
+std::vector<PlotBatch::Result> PlotBatch::Run() {
+    using Clock = std::chrono::steady_clock;
+
+    struct Running {
+        std::size_t index;
+        int fd;
+        Clock::time_point start;
+    };
+
+    std::vector<Result> results(jobs.size());
+    std::map<pid_t, Running> running;
+
+    // Collect a worker if it has exited, or wait for it without WNOHANG. Only the batch's own pids
+    // are waited on, so children the caller started elsewhere are left for the caller to reap.
+    // Returns true when the worker is no longer running.
+    auto waitFor = [&](pid_t pid, int options) {
+        int status = 0;
+        pid_t reaped;
+        do {
+            reaped = waitpid(pid, &status, options);
+        } while (reaped < 0 && errno == EINTR);
+        if (reaped == 0) return false;
+
+        auto found = running.find(pid);
+        Running worker = found->second;
+        running.erase(found);
+        Result& result = results[worker.index];
+
+        // Reaped by someone else, e.g. with SIGCHLD ignored, so its outcome cannot be known
+        if (reaped < 0) {
+            result.message = std::string("waitpid failed: ") + std::strerror(errno);
+            close(worker.fd);
+            return true;
+        }
+
+        result.message = readMessage(worker.fd);
+        close(worker.fd);
+        result.seconds = std::chrono::duration<double>(Clock::now() - worker.start).count();
+
+        if (WIFEXITED(status)) {
+            result.success = WEXITSTATUS(status) == 0;
+        } else if (WIFSIGNALED(status)) {
+            result.success = false;
+            result.message = "terminated by signal " + std::to_string(WTERMSIG(status));
+        }
+        return true;
+    };
+
+    // Wait for at least one worker to exit and record its result
+    auto reapOne = [&]() {
+        bool reaped = false;
+        for (auto it = running.begin(); it != running.end();) {
+            pid_t pid = (it++)->first;
+            reaped = waitFor(pid, WNOHANG) || reaped;
+        }
+        if (reaped || running.empty()) return;
+
+        // Sleep until any child has exited, without reaping it. A worker is collected by the next sweep;
+        // a child that is not ours stays waitable for its owner, so block on the oldest worker instead
+        siginfo_t info = {};
+        if (waitid(P_ALL, 0, &info, WEXITED | WNOWAIT) == 0 && running.count(info.si_pid)) return;
+
+        auto oldest = std::min_element(running.begin(), running.end(), [](const auto& a, const auto& b) {
+            return a.second.index < b.second.index;
+        });
+        waitFor(oldest->first, 0);
+    };
+
+    // Flush buffered output so it is not duplicated into every worker
+    std::fflush(stdout);
+    std::fflush(stderr);
+
+    for (std::size_t i = 0; i < jobs.size(); ++i) {
+        results[i].name = jobs[i].name;
+
+        while (static_cast<int>(running.size()) >= nWorkers) reapOne();
+
+        int fds[2];
+        if (pipe(fds) != 0) {
+            results[i].message = std::string("pipe failed: ") + std::strerror(errno);
+            continue;
+        }
+
+        pid_t pid = fork();
+        if (pid < 0) {
+            results[i].message = std::string("fork failed: ") + std::strerror(errno);
+            close(fds[0]);
+            close(fds[1]);
+            continue;
+        }
+
+        if (pid == 0) {
+            close(fds[0]);
+            runWorker(jobs[i].function, fds[1]);
+        }
+
+        close(fds[1]);
+        running[pid] = {i, fds[0], Clock::now()};
+    }
+
+    while (!running.empty()) reapOne();
+
+    return results;
+}
@@ -0,0 +1,43 @@
+#ifndef PLOT_BATCH_H
+#define PLOT_BATCH_H
+
+#include <functional>
+#include <string>
+#include <vector>
+
+// Renders independent plot jobs in a pool of forked worker processes.
+// ROOT graphics and gStyle are process-global, so each job gets its own process in batch mode
+// and writes its own output files; only the outcome of each job is reported back to the parent.
+class PlotBatch {
+public:
+    // Outcome of a single job, in the order the jobs were added
+    struct Result {
+        std::string name;
+        bool success = false;
+        std::string message;
+        double seconds = 0;
+    };
+
+    // Constructor, 0 workers means one per available core
+    PlotBatch(int workers = 0);
+
+    // Add a job; it should build a Plotter, call CreatePlot() and save its outputs
+    void AddJob(const std::string& name, std::function<void()> job);
+
+    // Run all jobs and wait for them to finish
+    std::vector<Result> Run();
+
+    int GetNumJobs() const { return jobs.size(); }
+    int GetNumWorkers() const { return nWorkers; }
+
+private:
+    struct Job {
+        std::string name;
+        std::function<void()> function;
+    };
+
+    int nWorkers;
+    std::vector<Job> jobs;
+};
+
+#endif
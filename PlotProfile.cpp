@@ -0,0 +1,76 @@
+#include "PlotProfile.h"
+
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+
+namespace {
+
+std::string escapeJson(const std::string& text) {
+    std::string escaped;
+    for (char c : text) {
+        switch (c) {
+            case '"': escaped += "\\\""; break;
+            case '\\': escaped += "\\\\"; break;
+            case '\n': escaped += "\\n"; break;
+            case '\t': escaped += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) >= 0x20) escaped += c;
+        }
+    }
+    return escaped;
+}
+
+// One complete ("X") event
+void writeEvent(std::ostream& out, const std::string& name, double start, double duration, int thread, const std::string& args) {
+    out << "{\"name\":\"" << escapeJson(name) << "\",\"cat\":\"rootPlotter\",\"ph\":\"X\",\"ts\":" << start << ",\"dur\":" << duration
+        << ",\"pid\":" << getpid() << ",\"tid\":" << thread;
+    if (!args.empty()) out << ",\"args\":{" << args << "}";
+    out << "}";
+}
+
+} // namespace
+
+double ProfileClock() {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int ProfileThread() {
+    static std::atomic<int> nextThread{0};
+    thread_local int thread = nextThread++;
+    return thread;
+}
+
+bool WritePlotTrace(const std::string& filename, const std::vector<PlotProfile>& profiles) {
+    std::ofstream out(filename);
+    if (!out) {
+        std::cerr << "Error: cannot open trace file " << filename << std::endl;
+        return false;
+    }
+    out.precision(15);
+
+    out << "{\"traceEvents\":[\n";
+    bool first = true;
+    for (const auto& profile : profiles) {
+        std::string args = "\"plot\":\"" + escapeJson(profile.plot) + "\"" +
+                           ",\"incremental\":" + (profile.incremental ? "true" : "false") +
+                           ",\"objectsDrawn\":" + std::to_string(profile.objectsDrawn) +
+                           ",\"pointsDrawn\":" + std::to_string(profile.pointsDrawn) +
+                           ",\"overlapTests\":" + std::to_string(profile.overlapTests) +
+                           ",\"rangeAttempts\":" + std::to_string(profile.rangeAttempts);
+        if (!first) out << ",\n";
+        writeEvent(out, "CreatePlot", profile.start, profile.duration, profile.thread, args);
+        first = false;
+
+        for (const auto& phase : profile.phases) {
+            out << ",\n";
+            writeEvent(out, phase.name, phase.start, phase.duration, profile.thread, "");
+        }
+    }
+    out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+    return static_cast<bool>(out);
+}
@@ -0,0 +1,44 @@
+#ifndef PLOT_PROFILE_H
+#define PLOT_PROFILE_H
+
+#include <string>
+#include <vector>
+
+// Timings and counters of one CreatePlot() call. Times are in microseconds of ProfileClock(),
+// so profiles of different plotters and threads line up on a single timeline.
+struct PlotProfile {
+    struct Phase {
+        std::string name;
+        double start;
+        double duration;
+    };
+
+    std::string plot;
+    int thread = 0;
+    double start = 0;
+    double duration = 0;
+    std::vector<Phase> phases;
+
+    // Live mode update without redrawing the objects
+    bool incremental = false;
+    int objectsDrawn = 0;
+    long long pointsDrawn = 0;
+    // Legend positions checked against the occupancy grid
+    long long overlapTests = 0;
+    // Legend positions tried while searching for the smallest y range expansion
+    long long rangeAttempts = 0;
+
+    void Clear() { *this = PlotProfile(); }
+};
+
+// Monotonic time in microseconds
+double ProfileClock();
+
+// Small stable id of the calling thread, used as the trace thread id
+int ProfileThread();
+
+// Write profiles as Chrome trace-event JSON, viewable in chrome://tracing or Perfetto.
+// Returns false if the file cannot be written.
+bool WritePlotTrace(const std::string& filename, const std::vector<PlotProfile>& profiles);
+
+#endif
@@ -0,0 +1,92 @@
+#ifndef PLOT_TRAITS_H
+#define PLOT_TRAITS_H
+
+#include <TH1.h>
+#include <TH1F.h>
+#include <TH1D.h>
+#include <TH1I.h>
+#include <TH1S.h>
+#include <TProfile.h>
+#include <TGraph.h>
+#include <TGraphErrors.h>
+#include <TGraphAsymmErrors.h>
+#include <TF1.h>
+#include <TEfficiency.h>
+
+#include <array>
+#include <string>
+#include <type_traits>
+
+// Kinds of objects the plotter knows how to draw
+enum class PlotObjectKind { Histogram, Graph, Function, Efficiency };
+
+// One configurable default draw option per supported object type
+enum class DrawOptionSlot { TH1F, TH1D, TH1I, TH1S, TH1, TProfile, TGraph, TGraphErrors, TGraphAsymmErrors, TF1, TEfficiency, Count };
+
+constexpr int kNumDrawOptionSlots = static_cast<int>(DrawOptionSlot::Count);
+
+// Draw option used when none is given to AddObject
+constexpr const char* DefaultDrawOption(DrawOptionSlot slot) {
+    switch (slot) {
+        case DrawOptionSlot::TProfile: return "PL E3";
+        case DrawOptionSlot::TGraph: return "PL";
+        case DrawOptionSlot::TGraphErrors: return "PL E3";
+        case DrawOptionSlot::TGraphAsymmErrors: return "PL E3";
+        case DrawOptionSlot::TF1: return "";
+        case DrawOptionSlot::TEfficiency: return "P";
+        default: return "EH";
+    }
+}
+
+// Default draw options of every slot, indexed by DrawOptionSlot
+inline std::array<std::string, kNumDrawOptionSlots> DefaultDrawOptions() {
+    std::array<std::string, kNumDrawOptionSlots> options;
+    for (int slot = 0; slot < kNumDrawOptionSlots; ++slot) {
+        options[slot] = DefaultDrawOption(static_cast<DrawOptionSlot>(slot));
+    }
+    return options;
+}
+
+// Compile-time description of how an object type is styled, bounded and drawn
+template <typename T>
+struct PlotTraits {
+    static_assert(std::is_base_of_v<TH1, T> || std::is_base_of_v<TGraph, T> || std::is_base_of_v<TF1, T> || std::is_base_of_v<TEfficiency, T>,
+                  "Plotter can only draw TH1, TGraph, TF1 and TEfficiency objects");
+
+    static constexpr PlotObjectKind kind =
+        std::is_base_of_v<TH1, T> ? PlotObjectKind::Histogram :
+        std::is_base_of_v<TGraph, T> ? PlotObjectKind::Graph :
+        std::is_base_of_v<TF1, T> ? PlotObjectKind::Function :
+        PlotObjectKind::Efficiency;
+
+    // Style attributes set when the object is added
+    static constexpr bool hasMarkers = std::is_base_of_v<TProfile, T> || kind == PlotObjectKind::Graph || kind == PlotObjectKind::Efficiency;
+    static constexpr bool hasFill = kind == PlotObjectKind::Histogram || kind == PlotObjectKind::Efficiency || (kind == PlotObjectKind::Graph && !std::is_same_v<T, TGraph>);
+
+    static constexpr DrawOptionSlot slot =
+        std::is_base_of_v<TProfile, T> ? DrawOptionSlot::TProfile :
+        std::is_base_of_v<TH1F, T> ? DrawOptionSlot::TH1F :
+        std::is_base_of_v<TH1D, T> ? DrawOptionSlot::TH1D :
+        std::is_base_of_v<TH1I, T> ? DrawOptionSlot::TH1I :
+        std::is_base_of_v<TH1S, T> ? DrawOptionSlot::TH1S :
+        std::is_base_of_v<TH1, T> ? DrawOptionSlot::TH1 :
+        std::is_base_of_v<TGraphErrors, T> ? DrawOptionSlot::TGraphErrors :
+        std::is_base_of_v<TGraphAsymmErrors, T> ? DrawOptionSlot::TGraphAsymmErrors :
+        std::is_base_of_v<TGraph, T> ? DrawOptionSlot::TGraph :
+        std::is_base_of_v<TF1, T> ? DrawOptionSlot::TF1 :
+        DrawOptionSlot::TEfficiency;
+
+    // Type whose bound computation is used for T. TH1F and TH1D bounds are computed directly on their
+    // bin arrays; a TProfile stores sums rather than bin contents, so it goes through TH1.
+    using HistogramBoundsType =
+        std::conditional_t<std::is_base_of_v<TProfile, T>, TH1,
+        std::conditional_t<std::is_base_of_v<TH1F, T>, TH1F,
+        std::conditional_t<std::is_base_of_v<TH1D, T>, TH1D, TH1>>>;
+
+    using BoundsType =
+        std::conditional_t<kind == PlotObjectKind::Histogram, HistogramBoundsType,
+        std::conditional_t<kind == PlotObjectKind::Graph, TGraph,
+        std::conditional_t<kind == PlotObjectKind::Function, TF1, TEfficiency>>>;
+};
+
+#endif
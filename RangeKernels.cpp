@@ -0,0 +1,138 @@
+#include "RangeKernels.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define RANGE_KERNELS_SIMD
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define RANGE_KERNELS_SIMD
+#endif
+
+namespace {
+
+#if defined(__AVX__)
+
+using Vec = __m256d;
+constexpr int kLanes = 4;
+
+inline Vec load(const double* p) { return _mm256_loadu_pd(p); }
+inline Vec load(const float* p) { return _mm256_cvtps_pd(_mm_loadu_ps(p)); }
+inline Vec splat(double v) { return _mm256_set1_pd(v); }
+inline Vec add(Vec a, Vec b) { return _mm256_add_pd(a, b); }
+inline Vec sub(Vec a, Vec b) { return _mm256_sub_pd(a, b); }
+inline Vec vmin(Vec a, Vec b) { return _mm256_min_pd(a, b); }
+inline Vec vmax(Vec a, Vec b) { return _mm256_max_pd(a, b); }
+inline Vec vsqrt(Vec a) { return _mm256_sqrt_pd(a); }
+inline Vec vabs(Vec a) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a); }
+inline void store(double* p, Vec a) { _mm256_storeu_pd(p, a); }
+
+#elif defined(__SSE2__)
+
+using Vec = __m128d;
+constexpr int kLanes = 2;
+
+inline Vec load(const double* p) { return _mm_loadu_pd(p); }
+inline Vec load(const float* p) { return _mm_cvtps_pd(_mm_castsi128_ps(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)))); }
+inline Vec splat(double v) { return _mm_set1_pd(v); }
+inline Vec add(Vec a, Vec b) { return _mm_add_pd(a, b); }
+inline Vec sub(Vec a, Vec b) { return _mm_sub_pd(a, b); }
+inline Vec vmin(Vec a, Vec b) { return _mm_min_pd(a, b); }
+inline Vec vmax(Vec a, Vec b) { return _mm_max_pd(a, b); }
+inline Vec vsqrt(Vec a) { return _mm_sqrt_pd(a); }
+inline Vec vabs(Vec a) { return _mm_andnot_pd(_mm_set1_pd(-0.0), a); }
+inline void store(double* p, Vec a) { _mm_storeu_pd(p, a); }
+
+#endif
+
+#ifdef RANGE_KERNELS_SIMD
+// Fold the lanes of the accumulators into min and max
+void reduce(Vec lo, Vec hi, double& min, double& max) {
+    double lanes[kLanes];
+    store(lanes, lo);
+    for (double v : lanes) min = std::min(min, v);
+    store(lanes, hi);
+    for (double v : lanes) max = std::max(max, v);
+}
+#endif
+
+// The SIMD min/max return their second operand when the first is NaN, so new values are always
+// passed first and NaN is skipped, like std::min(acc, value) in the scalar tail
+template <typename T>
+void histogramRange(const T* content, const double* sumw2, int n, double& min, double& max) {
+    min = std::numeric_limits<double>::max();
+    max = std::numeric_limits<double>::lowest();
+    int i = 0;
+
+#ifdef RANGE_KERNELS_SIMD
+    Vec lo = splat(min);
+    Vec hi = splat(max);
+    if (sumw2) {
+        for (; i + kLanes <= n; i += kLanes) {
+            Vec value = load(content + i);
+            Vec error = vsqrt(load(sumw2 + i));
+            lo = vmin(sub(value, error), lo);
+            hi = vmax(add(value, error), hi);
+        }
+    } else {
+        for (; i + kLanes <= n; i += kLanes) {
+            Vec value = load(content + i);
+            Vec error = vsqrt(vabs(value));
+            lo = vmin(sub(value, error), lo);
+            hi = vmax(add(value, error), hi);
+        }
+    }
+    reduce(lo, hi, min, max);
+#endif
+
+    for (; i < n; ++i) {
+        double value = content[i];
+        double error = sumw2 ? std::sqrt(sumw2[i]) : std::sqrt(std::abs(value));
+        min = std::min(min, value - error);
+        max = std::max(max, value + error);
+    }
+}
+
+} // namespace
+
+void RangeWithErrors(const double* values, const double* errLow, const double* errHigh, int n, double& min, double& max) {
+    min = std::numeric_limits<double>::max();
+    max = std::numeric_limits<double>::lowest();
+    int i = 0;
+
+#ifdef RANGE_KERNELS_SIMD
+    Vec lo = splat(min);
+    Vec hi = splat(max);
+    if (errLow && errHigh) {
+        for (; i + kLanes <= n; i += kLanes) {
+            Vec value = load(values + i);
+            lo = vmin(sub(value, load(errLow + i)), lo);
+            hi = vmax(add(value, load(errHigh + i)), hi);
+        }
+    } else if (!errLow && !errHigh) {
+        for (; i + kLanes <= n; i += kLanes) {
+            Vec value = load(values + i);
+            lo = vmin(value, lo);
+            hi = vmax(value, hi);
+        }
+    }
+    reduce(lo, hi, min, max);
+#endif
+
+    // Tail, or everything when only one side has errors
+    for (; i < n; ++i) {
+        min = std::min(min, values[i] - (errLow ? errLow[i] : 0));
+        max = std::max(max, values[i] + (errHigh ? errHigh[i] : 0));
+    }
+}
+
+void HistogramRange(const double* content, const double* sumw2, int n, double& min, double& max) {
+    histogramRange(content, sumw2, n, min, max);
+}
+
+void HistogramRange(const float* content, const double* sumw2, int n, double& min, double& max) {
+    histogramRange(content, sumw2, n, min, max);
+}
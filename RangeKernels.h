@@ -0,0 +1,16 @@
+#ifndef RANGE_KERNELS_H
+#define RANGE_KERNELS_H
+
+// Min/max kernels over contiguous arrays, vectorized with AVX when built with it, SSE2 otherwise
+// on x86-64, and scalar elsewhere. NaN values are skipped. With n == 0, min is the largest double
+// and max the lowest.
+
+// Range of values[i] - errLow[i] to values[i] + errHigh[i], a null error array counts as zero
+void RangeWithErrors(const double* values, const double* errLow, const double* errHigh, int n, double& min, double& max);
+
+// Range of histogram bin contents with their default errors: sqrt(sumw2[i]), or sqrt(|content[i]|)
+// when the histogram has no sum of squared weights (sumw2 == nullptr)
+void HistogramRange(const double* content, const double* sumw2, int n, double& min, double& max);
+void HistogramRange(const float* content, const double* sumw2, int n, double& min, double& max);
+
+#endif
@@ -0,0 +1,225 @@
+#include "SampleHistogram.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <thread>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+// Smallest chunk worth a thread of its own
+constexpr std::size_t kMinChunk = 1 << 16;
+// Values binned per block, small enough for the bin indices to stay in L1
+constexpr int kBlock = 256;
+// Bins of the histogram the spread of a sample is estimated from
+constexpr int kFineBins = 1 << 16;
+
+int threadCount(std::size_t n, int threads) {
+    if (threads <= 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    std::size_t useful = std::max<std::size_t>(1, n / kMinChunk);
+    return static_cast<int>(std::min<std::size_t>(threads, useful));
+}
+
+// Runs work(begin, end, chunk) on nThreads contiguous chunks of [0, n), the first on the calling thread
+template <typename Work>
+void forEachChunk(std::size_t n, int nThreads, const Work& work) {
+    std::vector<std::thread> workers;
+    for (int t = 1; t < nThreads; ++t) {
+        workers.emplace_back(work, n * t / nThreads, n * (t + 1) / nThreads, t);
+    }
+    work(0, n / nThreads, 0);
+    for (auto& worker : workers) worker.join();
+}
+
+// Partial histogram of one chunk
+struct Partial {
+    std::vector<std::uint64_t> counts;
+    double inRange = 0;
+    double sumX = 0;
+    double sumX2 = 0;
+};
+
+// Bin indices of one block with the arithmetic of TAxis::FindFixBin, written into slots, and the
+// statistics TH1::Fill accumulates for the values inside the axis range added to partial.
+// NaN fails every comparison and lands in overflow, as it does in ROOT.
+void binBlock(const double* block, int m, double bins, double low, double width, int* slots, Partial& partial) {
+    int i = 0;
+    double inRange = 0, sumX = 0, sumX2 = 0;
+
+#if defined(__SSE2__)
+    const __m128d vbins = _mm_set1_pd(bins);
+    const __m128d vlow = _mm_set1_pd(low);
+    const __m128d vwidth = _mm_set1_pd(width);
+    const __m128d zero = _mm_setzero_pd();
+    const __m128d underflow = _mm_set1_pd(-1.0);
+    const __m128d one = _mm_set1_pd(1.0);
+    const __m128i offset = _mm_set1_epi32(1);
+    __m128d count = zero, sum = zero, sum2 = zero;
+
+    for (; i + 2 <= m; i += 2) {
+        __m128d v = _mm_loadu_pd(block + i);
+        __m128d t = _mm_div_pd(_mm_mul_pd(vbins, _mm_sub_pd(v, vlow)), vwidth);
+        // min_pd returns its second operand when the first is NaN
+        t = _mm_min_pd(t, vbins);
+        __m128d above = _mm_cmpge_pd(t, zero);
+        __m128d in = _mm_and_pd(above, _mm_cmplt_pd(t, vbins));
+        t = _mm_or_pd(_mm_and_pd(above, t), _mm_andnot_pd(above, underflow));
+
+        __m128d x = _mm_and_pd(in, v);
+        count = _mm_add_pd(count, _mm_and_pd(in, one));
+        sum = _mm_add_pd(sum, x);
+        sum2 = _mm_add_pd(sum2, _mm_mul_pd(x, x));
+
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(slots + i), _mm_add_epi32(_mm_cvttpd_epi32(t), offset));
+    }
+
+    double lanes[2];
+    _mm_storeu_pd(lanes, count);
+    inRange += lanes[0] + lanes[1];
+    _mm_storeu_pd(lanes, sum);
+    sumX += lanes[0] + lanes[1];
+    _mm_storeu_pd(lanes, sum2);
+    sumX2 += lanes[0] + lanes[1];
+#endif
+
+    for (; i < m; ++i) {
+        double v = block[i];
+        double t = bins * (v - low) / width;
+        t = t < bins ? t : bins;
+        t = t >= 0 ? t : -1;
+        slots[i] = static_cast<int>(t) + 1;
+        if (t >= 0 && t < bins) {
+            inRange++;
+            sumX += v;
+            sumX2 += v * v;
+        }
+    }
+
+    partial.inRange += inRange;
+    partial.sumX += sumX;
+    partial.sumX2 += sumX2;
+}
+
+void fillChunk(const double* values, std::size_t n, int nBins, double low, double high, Partial& partial) {
+    int slots[kBlock];
+    for (std::size_t start = 0; start < n; start += kBlock) {
+        int m = static_cast<int>(std::min<std::size_t>(kBlock, n - start));
+        binBlock(values + start, m, nBins, low, high - low, slots, partial);
+        for (int i = 0; i < m; ++i) partial.counts[slots[i]]++;
+    }
+}
+
+// Value below which a fraction q of the binned sample lies, interpolated within its bin
+double quantile(const SampleCounts& counts, double total, double low, double binWidth, double q) {
+    double target = q * total;
+    double cumulative = 0;
+    int nBins = static_cast<int>(counts.bins.size()) - 2;
+    for (int bin = 1; bin <= nBins; ++bin) {
+        double content = counts.bins[bin];
+        if (content > 0 && cumulative + content >= target) {
+            return low + binWidth * (bin - 1 + (target - cumulative) / content);
+        }
+        cumulative += content;
+    }
+    return low + binWidth * nBins;
+}
+
+} // namespace
+
+SampleCounts BinSample(const double* values, std::size_t n, int nBins, double low, double high, int threads) {
+    int nThreads = threadCount(n, threads);
+    std::vector<Partial> partials(nThreads);
+    for (auto& partial : partials) partial.counts.assign(nBins + 2, 0);
+
+    forEachChunk(n, nThreads, [&](std::size_t begin, std::size_t end, int chunk) {
+        fillChunk(values + begin, end - begin, nBins, low, high, partials[chunk]);
+    });
+
+    // Partials are merged in chunk order, so the sums do not depend on thread timing
+    SampleCounts result;
+    result.bins.assign(nBins + 2, 0.0);
+    result.entries = static_cast<double>(n);
+    for (const auto& partial : partials) {
+        for (int cell = 0; cell < nBins + 2; ++cell) result.bins[cell] += partial.counts[cell];
+        result.inRange += partial.inRange;
+        result.sumX += partial.sumX;
+        result.sumX2 += partial.sumX2;
+    }
+    return result;
+}
+
+void ChooseBinning(const double* values, std::size_t n, BinRule rule, int& nBins, double& low, double& high, int maxBins, int threads) {
+    // Range of the finite values
+    int nThreads = threadCount(n, threads);
+    std::vector<double> mins(nThreads, std::numeric_limits<double>::max());
+    std::vector<double> maxs(nThreads, std::numeric_limits<double>::lowest());
+    forEachChunk(n, nThreads, [&](std::size_t begin, std::size_t end, int chunk) {
+        double lo = mins[chunk], hi = maxs[chunk];
+        for (std::size_t i = begin; i < end; ++i) {
+            double v = values[i];
+            if (!std::isfinite(v)) continue;
+            lo = std::min(lo, v);
+            hi = std::max(hi, v);
+        }
+        mins[chunk] = lo;
+        maxs[chunk] = hi;
+    });
+    double min = *std::min_element(mins.begin(), mins.end());
+    double max = *std::max_element(maxs.begin(), maxs.end());
+
+    if (min > max) {
+        nBins = 1;
+        low = 0;
+        high = 1;
+        return;
+    }
+    if (min == max) {
+        nBins = 1;
+        low = min - 0.5;
+        high = max + 0.5;
+        return;
+    }
+
+    // Fine histogram of the finite values, slightly wider than their range so the maximum is inside it
+    double range = max - min;
+    double fineHigh = max + range * 1e-9;
+    double fineWidth = (fineHigh - min) / kFineBins;
+    SampleCounts fine = BinSample(values, n, kFineBins, min, fineHigh, threads);
+    double total = fine.inRange;
+
+    // Quartiles and standard deviation from the fine histogram, whose resolution is far below any chosen width
+    double q1 = quantile(fine, total, min, fineWidth, 0.25);
+    double q3 = quantile(fine, total, min, fineWidth, 0.75);
+
+    double mean = 0;
+    for (int bin = 1; bin <= kFineBins; ++bin) mean += fine.bins[bin] * (min + fineWidth * (bin - 0.5));
+    mean /= total;
+    double variance = 0;
+    for (int bin = 1; bin <= kFineBins; ++bin) {
+        double d = min + fineWidth * (bin - 0.5) - mean;
+        variance += fine.bins[bin] * d * d;
+    }
+    double sigma = std::sqrt(variance / total);
+
+    double scale = std::cbrt(total);
+    double width = rule == BinRule::FreedmanDiaconis ? 2 * (q3 - q1) / scale : 0;
+    // A sample concentrated on a few values can have no interquartile range, Scott's rule still applies
+    if (width <= 0) width = 3.49 * sigma / scale;
+
+    double count = width > 0 ? std::floor(range / width) + 1 : 1;
+    if (count > maxBins) {
+        count = maxBins;
+        width = range * (1 + 1e-9) / maxBins;
+    } else if (width <= 0) {
+        width = range * (1 + 1e-9);
+    }
+
+    nBins = static_cast<int>(count);
+    low = min;
+    high = min + nBins * width;
+}
@@ -0,0 +1,34 @@
+#ifndef SAMPLE_HISTOGRAM_H
+#define SAMPLE_HISTOGRAM_H
+
+#include <cstddef>
+#include <vector>
+
+// Parallel binning of large unbinned samples. The sample is split into one contiguous chunk per
+// thread, each thread fills its own partial histogram and the partials are summed at the end.
+// A thread count of 0 uses one thread per core, and small samples are binned on the calling thread.
+// Bin indices are computed two values at a time with SSE2 on x86-64.
+
+// Rules choosing the bin width from the sample itself
+enum class BinRule { FreedmanDiaconis, Scott };
+
+// Bin contents and fill statistics of a sample, as TH1::Fill would have produced them
+struct SampleCounts {
+    // nBins + 2 cells: underflow, the bins, overflow. NaN values count as overflow, as in TAxis::FindBin.
+    std::vector<double> bins;
+    double entries = 0;
+    // Number, sum and sum of squares of the values inside [low, high)
+    double inRange = 0;
+    double sumX = 0;
+    double sumX2 = 0;
+};
+
+// Bin values into nBins equal bins on [low, high)
+SampleCounts BinSample(const double* values, std::size_t n, int nBins, double low, double high, int threads = 0);
+
+// Binning chosen by rule, covering every finite value of the sample. The spread the rules need, the
+// interquartile range or standard deviation, is estimated from a fine parallel histogram of the sample.
+// The number of bins is limited to maxBins.
+void ChooseBinning(const double* values, std::size_t n, BinRule rule, int& nBins, double& low, double& high, int maxBins = 10000, int threads = 0);
+
+#endif
@@ -0,0 +1,240 @@
+#include "SharedHistogram.h"
+
+#include <TH1.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <new>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sched.h>
+#include <unistd.h>
+
+namespace {
+
+const std::uint32_t kMagic = 0x52504853;  // "RPHS"
+const std::uint32_t kVersion = 1;
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "the sequence lock must work across processes");
+
+// Start of the region, followed by the published block
+struct Header {
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::int32_t nBins;
+    std::int32_t reserved;
+    double xmin;
+    double xmax;
+    // Odd while a publish is in progress
+    std::atomic<std::uint64_t> sequence;
+    char title[128];
+};
+
+// Published block: entries, whether sumw2 is set, the four stats, nBins + 2 contents, nBins + 2 sumw2
+const int kFixedValues = 6;
+
+std::size_t blockValues(int nBins) {
+    return kFixedValues + 2 * static_cast<std::size_t>(nBins + 2);
+}
+
+std::size_t regionSize(int nBins) {
+    return sizeof(Header) + blockValues(nBins) * sizeof(double);
+}
+
+std::string shmName(const std::string& name) {
+    return (!name.empty() && name[0] == '/') ? name : "/" + name;
+}
+
+} // namespace
+
+SharedHistogramWriter::SharedHistogramWriter(const std::string& name, int nBins, double xmin, double xmax, const std::string& title)
+    : name(shmName(name)), nBins(nBins), size(regionSize(nBins)), buffer(blockValues(nBins), 0.0) {
+    int fd = shm_open(this->name.c_str(), O_CREAT | O_RDWR, 0644);
+    if (fd < 0) {
+        std::cerr << "Error: shm_open " << this->name << ": " << std::strerror(errno) << std::endl;
+        return;
+    }
+    if (ftruncate(fd, size) != 0) {
+        std::cerr << "Error: cannot size " << this->name << ": " << std::strerror(errno) << std::endl;
+        close(fd);
+        return;
+    }
+
+    void* mapped = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        std::cerr << "Error: mmap " << this->name << ": " << std::strerror(errno) << std::endl;
+        return;
+    }
+    region = mapped;
+
+    Header* header = static_cast<Header*>(region);
+    header->magic = 0;
+    header->nBins = nBins;
+    header->reserved = 0;
+    header->xmin = xmin;
+    header->xmax = xmax;
+    std::strncpy(header->title, title.c_str(), sizeof(header->title) - 1);
+    header->title[sizeof(header->title) - 1] = '\0';
+    new (&header->sequence) std::atomic<std::uint64_t>(0);
+    std::memset(reinterpret_cast<double*>(header + 1), 0, blockValues(nBins) * sizeof(double));
+
+    // Readers only accept the region once it is fully set up
+    header->version = kVersion;
+    std::atomic_thread_fence(std::memory_order_release);
+    header->magic = kMagic;
+}
+
+SharedHistogramWriter::~SharedHistogramWriter() {
+    if (!region) return;
+    munmap(region, size);
+    // Readers that already mapped the region keep it until they unmap it
+    shm_unlink(name.c_str());
+}
+
+void SharedHistogramWriter::Publish(const double* contents, const double* sumw2, double entries, const double* stats) {
+    if (!region) return;
+    Header* header = static_cast<Header*>(region);
+    double* block = reinterpret_cast<double*>(header + 1);
+    std::size_t cells = nBins + 2;
+
+    std::uint64_t sequence = header->sequence.load(std::memory_order_relaxed);
+    header->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    block[0] = entries;
+    block[1] = sumw2 ? 1 : 0;
+    for (int i = 0; i < 4; ++i) block[2 + i] = stats ? stats[i] : 0;
+    std::memcpy(block + kFixedValues, contents, cells * sizeof(double));
+    if (sumw2) std::memcpy(block + kFixedValues + cells, sumw2, cells * sizeof(double));
+
+    header->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+void SharedHistogramWriter::Publish(const TH1* hist) {
+    if (hist->GetNbinsX() != nBins) {
+        std::cerr << "Error: " << hist->GetName() << " has " << hist->GetNbinsX() << " bins, " << name << " has " << nBins << std::endl;
+        return;
+    }
+
+    std::size_t cells = nBins + 2;
+    double* contents = buffer.data();
+    for (std::size_t bin = 0; bin < cells; ++bin) contents[bin] = hist->GetBinContent(bin);
+
+    const double* sumw2 = hist->GetSumw2N() ? hist->GetSumw2()->GetArray() : nullptr;
+
+    double stats[13] = {};
+    hist->GetStats(stats);
+    Publish(contents, sumw2, hist->GetEntries(), stats);
+}
+
+SharedHistogramReader::SharedHistogramReader(const std::string& name) : name(shmName(name)) {
+    int fd = shm_open(this->name.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        std::cerr << "Error: shm_open " << this->name << ": " << std::strerror(errno) << std::endl;
+        return;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<std::size_t>(info.st_size) < sizeof(Header)) {
+        std::cerr << "Error: " << this->name << " is not a shared histogram" << std::endl;
+        close(fd);
+        return;
+    }
+
+    void* mapped = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        std::cerr << "Error: mmap " << this->name << ": " << std::strerror(errno) << std::endl;
+        return;
+    }
+
+    const Header* header = static_cast<const Header*>(mapped);
+    bool valid = header->magic == kMagic;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    valid = valid && header->version == kVersion && header->nBins > 0 && regionSize(header->nBins) <= static_cast<std::size_t>(info.st_size);
+    if (!valid) {
+        std::cerr << "Error: " << this->name << " is not a shared histogram" << std::endl;
+        munmap(mapped, info.st_size);
+        return;
+    }
+
+    region = mapped;
+    size = info.st_size;
+    buffer.resize(blockValues(header->nBins));
+}
+
+SharedHistogramReader::~SharedHistogramReader() {
+    if (region) munmap(const_cast<void*>(region), size);
+}
+
+int SharedHistogramReader::GetNbins() const {
+    return region ? static_cast<const Header*>(region)->nBins : 0;
+}
+
+double SharedHistogramReader::GetXmin() const {
+    return region ? static_cast<const Header*>(region)->xmin : 0;
+}
+
+double SharedHistogramReader::GetXmax() const {
+    return region ? static_cast<const Header*>(region)->xmax : 0;
+}
+
+std::string SharedHistogramReader::GetTitle() const {
+    return region ? static_cast<const Header*>(region)->title : "";
+}
+
+std::uint64_t SharedHistogramReader::GetRevision() const {
+    return region ? static_cast<const Header*>(region)->sequence.load(std::memory_order_acquire) / 2 : 0;
+}
+
+TH1D* SharedHistogramReader::CreateHistogram(const std::string& histName) const {
+    TH1D* hist = new TH1D(histName.c_str(), GetTitle().c_str(), GetNbins(), GetXmin(), GetXmax());
+    hist->SetDirectory(nullptr);
+    return hist;
+}
+
+bool SharedHistogramReader::Snapshot(TH1D* hist, int maxAttempts) const {
+    if (!region) return false;
+    const Header* header = static_cast<const Header*>(region);
+    const double* block = reinterpret_cast<const double*>(header + 1);
+    int nBins = header->nBins;
+    std::size_t cells = nBins + 2;
+
+    if (hist->GetNbinsX() != nBins) {
+        std::cerr << "Error: " << hist->GetName() << " has " << hist->GetNbinsX() << " bins, " << name << " has " << nBins << std::endl;
+        return false;
+    }
+
+    // Copy into a scratch block and only keep it if no publish started or finished meanwhile
+    bool consistent = false;
+    for (int attempt = 0; attempt < maxAttempts && !consistent; ++attempt) {
+        std::uint64_t before = header->sequence.load(std::memory_order_acquire);
+        if (before & 1) {
+            sched_yield();
+            continue;
+        }
+        std::memcpy(buffer.data(), block, buffer.size() * sizeof(double));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        consistent = header->sequence.load(std::memory_order_relaxed) == before;
+    }
+    if (!consistent) return false;
+
+    std::memcpy(hist->GetArray(), buffer.data() + kFixedValues, cells * sizeof(double));
+    if (buffer[1] != 0) {
+        if (!hist->GetSumw2N()) hist->Sumw2();
+        std::memcpy(hist->GetSumw2()->GetArray(), buffer.data() + kFixedValues + cells, cells * sizeof(double));
+    } else if (hist->GetSumw2N()) {
+        hist->Sumw2(false);
+    }
+
+    double stats[13] = {};
+    std::memcpy(stats, buffer.data() + 2, 4 * sizeof(double));
+    hist->PutStats(stats);
+    hist->SetEntries(buffer[0]);
+    return true;
+}
@@ -0,0 +1,78 @@
+#ifndef SHARED_HISTOGRAM_H
+#define SHARED_HISTOGRAM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class TH1;
+class TH1D;
+
+// 1D histograms shared between processes through POSIX shared memory. The producer publishes the
+// bin arrays into the region under a sequence lock, so publishing never waits for readers, and
+// readers retry until they copy a snapshot that no publish overlapped.
+
+// Producer side, creates the region and removes its name again when destroyed
+class SharedHistogramWriter {
+public:
+    // Constructor, name is a shared memory name such as "/daq_pt"
+    SharedHistogramWriter(const std::string& name, int nBins, double xmin, double xmax, const std::string& title = "");
+    // Destructor
+    ~SharedHistogramWriter();
+
+    SharedHistogramWriter(const SharedHistogramWriter&) = delete;
+    SharedHistogramWriter& operator=(const SharedHistogramWriter&) = delete;
+
+    bool IsValid() const { return region != nullptr; }
+
+    // Publish nBins + 2 contents and squared weight sums (including under- and overflow), the number of
+    // entries and optionally the four 1D statistics of TH1::GetStats. sumw2 may be null for unweighted data.
+    void Publish(const double* contents, const double* sumw2, double entries, const double* stats = nullptr);
+    // Publish a histogram with the same number of bins
+    void Publish(const TH1* hist);
+
+private:
+    std::string name;
+    int nBins;
+    void* region = nullptr;
+    std::size_t size = 0;
+    std::vector<double> buffer;
+};
+
+// Consumer side, maps an existing region read-only
+class SharedHistogramReader {
+public:
+    // Constructor
+    SharedHistogramReader(const std::string& name);
+    // Destructor
+    ~SharedHistogramReader();
+
+    SharedHistogramReader(const SharedHistogramReader&) = delete;
+    SharedHistogramReader& operator=(const SharedHistogramReader&) = delete;
+
+    bool IsValid() const { return region != nullptr; }
+
+    int GetNbins() const;
+    double GetXmin() const;
+    double GetXmax() const;
+    std::string GetTitle() const;
+
+    // Number of publishes so far
+    std::uint64_t GetRevision() const;
+
+    // Empty histogram with the binning and title of the source, not attached to any directory
+    TH1D* CreateHistogram(const std::string& name) const;
+
+    // Copy a consistent snapshot into hist, which must have the binning of the source.
+    // Returns false, leaving hist unchanged, if every attempt overlapped a publish.
+    bool Snapshot(TH1D* hist, int maxAttempts = 1000) const;
+
+private:
+    std::string name;
+    const void* region = nullptr;
+    std::size_t size = 0;
+    mutable std::vector<double> buffer;
+};
+
+#endif
@@ -0,0 +1,32 @@
+#include "SubmissionQueue.h"
+
+#include <algorithm>
+#include <utility>
+
+SubmissionQueue::~SubmissionQueue() {
+    TakeAll();
+}
+
+void SubmissionQueue::Push(Item item) {
+    Node* node = new Node{std::move(item), head.load(std::memory_order_relaxed)};
+    while (!head.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed)) {
+    }
+}
+
+std::vector<SubmissionQueue::Item> SubmissionQueue::TakeAll() {
+    Node* node = head.exchange(nullptr, std::memory_order_acquire);
+
+    std::vector<Item> items;
+    while (node) {
+        Node* next = node->next;
+        items.push_back(std::move(node->item));
+        delete node;
+        node = next;
+    }
+
+    // The list comes out newest first; sorting makes the order independent of thread timing
+    std::sort(items.begin(), items.end(), [](const Item& a, const Item& b) {
+        return a.order != b.order ? a.order < b.order : a.name < b.name;
+    });
+    return items;
+}
@@ -0,0 +1,45 @@
+#ifndef SUBMISSION_QUEUE_H
+#define SUBMISSION_QUEUE_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Lock-free multi-producer, single-consumer queue of deferred additions to a plot.
+// Any thread may push; only the owning thread takes the items, which are returned sorted by
+// (order, name) so the result does not depend on which producer pushed first.
+class SubmissionQueue {
+public:
+    struct Item {
+        std::uint64_t order;
+        std::string name;
+        std::function<void()> apply;
+    };
+
+    SubmissionQueue() = default;
+    // Destructor, drops items that were never taken
+    ~SubmissionQueue();
+
+    SubmissionQueue(const SubmissionQueue&) = delete;
+    SubmissionQueue& operator=(const SubmissionQueue&) = delete;
+
+    // Safe to call from any thread
+    void Push(Item item);
+
+    // Take every queued item, owning thread only
+    std::vector<Item> TakeAll();
+
+    bool Empty() const { return head.load(std::memory_order_acquire) == nullptr; }
+
+private:
+    struct Node {
+        Item item;
+        Node* next;
+    };
+
+    std::atomic<Node*> head{nullptr};
+};
+
+#endif
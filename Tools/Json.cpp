@@ -0,0 +1,229 @@
+#include "Json.h"
+
+#include <cstdlib>
+#include <stdexcept>
+
+namespace {
+
+class Parser {
+public:
+    Parser(const std::string& text) : text(text) {}
+
+    JsonValue ParseDocument() {
+        JsonValue value = parseValue();
+        skipSpace();
+        if (pos != text.size()) fail("unexpected trailing characters");
+        return value;
+    }
+
+private:
+    const std::string& text;
+    std::size_t pos = 0;
+
+    [[noreturn]] void fail(const std::string& what) const {
+        int line = 1;
+        for (std::size_t i = 0; i < pos && i < text.size(); ++i) {
+            if (text[i] == '\n') line++;
+        }
+        throw std::runtime_error("JSON error on line " + std::to_string(line) + ": " + what);
+    }
+
+    void skipSpace() {
+        while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\t' || text[pos] == '\n' || text[pos] == '\r')) pos++;
+    }
+
+    void expect(char c) {
+        skipSpace();
+        if (pos >= text.size() || text[pos] != c) fail(std::string("expected '") + c + "'");
+        pos++;
+    }
+
+    bool consumeWord(const char* word) {
+        std::size_t length = std::char_traits<char>::length(word);
+        if (text.compare(pos, length, word) != 0) return false;
+        pos += length;
+        return true;
+    }
+
+    JsonValue parseValue() {
+        skipSpace();
+        if (pos >= text.size()) fail("unexpected end of input");
+
+        JsonValue value;
+        char c = text[pos];
+        if (c == '{') {
+            value.type = JsonValue::Type::Object;
+            pos++;
+            skipSpace();
+            if (pos < text.size() && text[pos] == '}') {
+                pos++;
+                return value;
+            }
+            while (true) {
+                skipSpace();
+                std::string key = parseString();
+                expect(':');
+                value.object.emplace_back(key, parseValue());
+                skipSpace();
+                if (pos < text.size() && text[pos] == ',') {
+                    pos++;
+                    continue;
+                }
+                expect('}');
+                return value;
+            }
+        }
+        if (c == '[') {
+            value.type = JsonValue::Type::Array;
+            pos++;
+            skipSpace();
+            if (pos < text.size() && text[pos] == ']') {
+                pos++;
+                return value;
+            }
+            while (true) {
+                value.array.push_back(parseValue());
+                skipSpace();
+                if (pos < text.size() && text[pos] == ',') {
+                    pos++;
+                    continue;
+                }
+                expect(']');
+                return value;
+            }
+        }
+        if (c == '"') {
+            value.type = JsonValue::Type::String;
+            value.string = parseString();
+            return value;
+        }
+        if (consumeWord("true")) {
+            value.type = JsonValue::Type::Bool;
+            value.boolean = true;
+            return value;
+        }
+        if (consumeWord("false")) {
+            value.type = JsonValue::Type::Bool;
+            return value;
+        }
+        if (consumeWord("null")) return value;
+
+        const char* start = text.c_str() + pos;
+        char* end = nullptr;
+        value.number = std::strtod(start, &end);
+        if (end == start) fail("unexpected character");
+        value.type = JsonValue::Type::Number;
+        pos += end - start;
+        return value;
+    }
+
+    // The four hexadecimal digits of a \u escape
+    unsigned long parseHex4() {
+        if (pos + 4 > text.size()) fail("incomplete \\u escape");
+        unsigned long code = 0;
+        for (int i = 0; i < 4; ++i) {
+            char c = text[pos++];
+            int digit;
+            if (c >= '0' && c <= '9') digit = c - '0';
+            else if (c >= 'a' && c <= 'f') digit = c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F') digit = c - 'A' + 10;
+            else fail("invalid \\u escape");
+            code = code * 16 + digit;
+        }
+        return code;
+    }
+
+    static void appendUtf8(std::string& result, unsigned long code) {
+        if (code < 0x80) {
+            result += static_cast<char>(code);
+        } else if (code < 0x800) {
+            result += static_cast<char>(0xC0 | (code >> 6));
+            result += static_cast<char>(0x80 | (code & 0x3F));
+        } else if (code < 0x10000) {
+            result += static_cast<char>(0xE0 | (code >> 12));
+            result += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            result += static_cast<char>(0x80 | (code & 0x3F));
+        } else {
+            result += static_cast<char>(0xF0 | (code >> 18));
+            result += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+            result += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            result += static_cast<char>(0x80 | (code & 0x3F));
+        }
+    }
+
+    std::string parseString() {
+        if (pos >= text.size() || text[pos] != '"') fail("expected a string");
+        pos++;
+
+        std::string result;
+        while (pos < text.size() && text[pos] != '"') {
+            char c = text[pos++];
+            if (c != '\\') {
+                result += c;
+                continue;
+            }
+            if (pos >= text.size()) break;
+            char escaped = text[pos++];
+            switch (escaped) {
+                case 'n': result += '\n'; break;
+                case 't': result += '\t'; break;
+                case 'r': result += '\r'; break;
+                case 'b': result += '\b'; break;
+                case 'f': result += '\f'; break;
+                case 'u': {
+                    unsigned long code = parseHex4();
+                    // A high surrogate must be followed by an escaped low surrogate, together one code point
+                    if (code >= 0xD800 && code <= 0xDBFF) {
+                        if (text.compare(pos, 2, "\\u") != 0) fail("unpaired surrogate in \\u escape");
+                        pos += 2;
+                        unsigned long low = parseHex4();
+                        if (low < 0xDC00 || low > 0xDFFF) fail("unpaired surrogate in \\u escape");
+                        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                    } else if (code >= 0xDC00 && code <= 0xDFFF) {
+                        fail("unpaired surrogate in \\u escape");
+                    }
+                    appendUtf8(result, code);
+                    break;
+                }
+                default: result += escaped;
+            }
+        }
+        if (pos >= text.size()) fail("unterminated string");
+        pos++;
+        return result;
+    }
+};
+
+} // namespace
+
+const JsonValue* JsonValue::Find(const std::string& key) const {
+    for (const auto& member : object) {
+        if (member.first == key) return &member.second;
+    }
+    return nullptr;
+}
+
+std::string JsonValue::GetString(const std::string& key, const std::string& fallback) const {
+    const JsonValue* value = Find(key);
+    if (!value || value->IsNull()) return fallback;
+    if (value->type != Type::String) throw std::runtime_error("\"" + key + "\" must be a string");
+    return value->string;
+}
+
+double JsonValue::GetNumber(const std::string& key, double fallback) const {
+    const JsonValue* value = Find(key);
+    if (!value || value->IsNull()) return fallback;
+    if (value->type != Type::Number) throw std::runtime_error("\"" + key + "\" must be a number");
+    return value->number;
+}
+
+bool JsonValue::GetBool(const std::string& key, bool fallback) const {
+    const JsonValue* value = Find(key);
+    if (!value || value->IsNull()) return fallback;
+    if (value->type != Type::Bool) throw std::runtime_error("\"" + key + "\" must be true or false");
+    return value->boolean;
+}
+
+JsonValue ParseJson(const std::string& text) {
+    return Parser(text).ParseDocument();
+}
@@ -0,0 +1,35 @@
+#ifndef JSON_H
+#define JSON_H
+
+#include <string>
+#include <utility>
+#include <vector>
+
+// Minimal JSON document model for plot specs. Objects keep their keys in file order.
+struct JsonValue {
+    enum class Type { Null, Bool, Number, String, Array, Object };
+
+    Type type = Type::Null;
+    bool boolean = false;
+    double number = 0;
+    std::string string;
+    std::vector<JsonValue> array;
+    std::vector<std::pair<std::string, JsonValue>> object;
+
+    bool IsNull() const { return type == Type::Null; }
+    bool IsArray() const { return type == Type::Array; }
+    bool IsObject() const { return type == Type::Object; }
+
+    // Member of an object, nullptr if missing or if this is not an object
+    const JsonValue* Find(const std::string& key) const;
+
+    // Typed members with a default for missing keys; a present member of the wrong type throws
+    std::string GetString(const std::string& key, const std::string& fallback = "") const;
+    double GetNumber(const std::string& key, double fallback = 0) const;
+    bool GetBool(const std::string& key, bool fallback = false) const;
+};
+
+// Parse a JSON document, throws std::runtime_error with the line of the first error
+JsonValue ParseJson(const std::string& text);
+
+#endif
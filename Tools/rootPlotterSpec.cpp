@@ -0,0 +1,292 @@
+#include "rootPlotter.h"
+#include "PlotBatch.h"
+#include "Json.h"
+
+#include <TFile.h>
+#include <TROOT.h>
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Renders every plot described in a JSON spec:
+//
+// {
+//   "workers": 4,                       // parallel plots, default one per core
+//   "cacheDir": "cache",                // optional, reuse unchanged plots through RenderCached()
+//   "plots": [
+//     {
+//       "output": "plots/pt",           // written as plots/pt.<format>
+//       "formats": ["png", "pdf"],      // default ["png"]
+//       "width": 800, "height": 600,
+//       "title": "...", "xTitle": "...", "yTitle": "...",
+//       "xRange": [0, 100], "yRange": [0, 1e4],
+//       "font": 102,
+//       "decimation": "minmax",         // "none", "minmax" or "lttb"
+//       "stats": [0.7, 0.9, 0.6, 0.9],  // or true for the default position
+//       "legend": {"show": true, "width": 0.3, "height": 0.2,
+//                  "position": "upperRight"},  // a preset name or [xmin, xmax, ymin, ymax]
+//       "objects": [
+//         {"file": "data.root", "name": "hPt", "label": "Data", "draw": "EH", "legend": true, "newColor": true}
+//       ]
+//     }
+//   ]
+// }
+//
+// Each input file is opened once and every object read once, before any plot is drawn. Plots are then
+// rendered in parallel by forked workers, which share the loaded objects with the parent.
+//
+// Usage: rootPlotterSpec spec.json [--workers n]
+
+namespace {
+
+using ObjectKey = std::pair<std::string, std::string>;
+using LoadedObjects = std::map<ObjectKey, TObject*>;
+
+std::string readFile(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) throw std::runtime_error("cannot open " + path);
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    return buffer.str();
+}
+
+const std::vector<JsonValue>& arrayMember(const JsonValue& value, const std::string& key) {
+    static const std::vector<JsonValue> empty;
+    const JsonValue* member = value.Find(key);
+    if (!member || member->IsNull()) return empty;
+    if (!member->IsArray()) throw std::runtime_error("\"" + key + "\" must be an array");
+    return member->array;
+}
+
+// Numbers of an array member, which must have the given length
+std::vector<double> numbers(const JsonValue& value, const std::string& key, std::size_t length) {
+    std::vector<double> result;
+    for (const auto& item : arrayMember(value, key)) {
+        if (item.type != JsonValue::Type::Number) throw std::runtime_error("\"" + key + "\" must only hold numbers");
+        result.push_back(item.number);
+    }
+    if (!result.empty() && result.size() != length) {
+        throw std::runtime_error("\"" + key + "\" must hold " + std::to_string(length) + " numbers");
+    }
+    return result;
+}
+
+// Strings of an array member
+std::vector<std::string> strings(const JsonValue& value, const std::string& key) {
+    std::vector<std::string> result;
+    for (const auto& item : arrayMember(value, key)) {
+        if (item.type != JsonValue::Type::String) throw std::runtime_error("\"" + key + "\" must only hold strings");
+        result.push_back(item.string);
+    }
+    return result;
+}
+
+// Read every object named in the spec, opening each file once. Returns false if anything is missing.
+bool loadObjects(const JsonValue& spec, LoadedObjects& loaded) {
+    std::map<std::string, std::vector<std::string>> namesByFile;
+    for (const auto& plot : arrayMember(spec, "plots")) {
+        for (const auto& object : arrayMember(plot, "objects")) {
+            ObjectKey key{object.GetString("file"), object.GetString("name")};
+            if (loaded.emplace(key, nullptr).second) namesByFile[key.first].push_back(key.second);
+        }
+    }
+
+    bool ok = true;
+    TH1::AddDirectory(kFALSE);
+    for (const auto& [path, names] : namesByFile) {
+        TFile* file = TFile::Open(path.c_str(), "READ");
+        if (!file || file->IsZombie()) {
+            std::cerr << "Error: cannot open " << path << std::endl;
+            delete file;
+            ok = false;
+            continue;
+        }
+
+        for (const auto& name : names) {
+            TObject* object = file->Get(name.c_str());
+            if (!object) {
+                std::cerr << "Error: " << name << " not found in " << path << std::endl;
+                ok = false;
+                continue;
+            }
+
+            // Detach histograms from the file so they outlive it
+            if (TH1* hist = dynamic_cast<TH1*>(object)) hist->SetDirectory(nullptr);
+            loaded[{path, name}] = object;
+        }
+
+        file->Close();
+        delete file;
+    }
+    return ok;
+}
+
+// AddObject with the most derived type the plotter supports
+void addObject(Plotter& plotter, TObject* object, const std::string& label, bool addLegend, bool newColor, const std::string& drawOption) {
+    auto add = [&](auto* typed) {
+        plotter.AddObject(typed, label, addLegend, newColor, drawOption, Plotter::Ownership::Borrowed);
+    };
+
+    if (auto typed = dynamic_cast<TProfile*>(object)) add(typed);
+    else if (auto typed = dynamic_cast<TH1F*>(object)) add(typed);
+    else if (auto typed = dynamic_cast<TH1D*>(object)) add(typed);
+    else if (auto typed = dynamic_cast<TH1I*>(object)) add(typed);
+    else if (auto typed = dynamic_cast<TH1S*>(object)) add(typed);
+    else if (auto typed = dynamic_cast<TH1*>(object)) add(typed);
+    else if (auto typed = dynamic_cast<TGraphAsymmErrors*>(object)) add(typed);
+    else if (auto typed = dynamic_cast<TGraphErrors*>(object)) add(typed);
+    else if (auto typed = dynamic_cast<TGraph*>(object)) add(typed);
+    else if (auto typed = dynamic_cast<TF1*>(object)) add(typed);
+    else if (auto typed = dynamic_cast<TEfficiency*>(object)) add(typed);
+    else throw std::runtime_error(std::string(object->GetName()) + " is a " + object->ClassName() + ", which cannot be plotted");
+}
+
+void applyLegend(Plotter& plotter, const JsonValue& legend) {
+    plotter.ShowLegend(legend.GetBool("show", true));
+    plotter.SetLegendSize(legend.GetNumber("width", 0.3), legend.GetNumber("height", 0.2));
+
+    const JsonValue* position = legend.Find("position");
+    if (!position || position->IsNull()) return;
+    if (position->IsArray()) {
+        std::vector<double> box = numbers(legend, "position", 4);
+        plotter.SetLegendPosition(box[0], box[1], box[2], box[3]);
+        return;
+    }
+
+    std::string name = legend.GetString("position");
+    if (name == "auto") return;
+    else if (name == "upperRight") plotter.SetLegendUpperRight();
+    else if (name == "upperCenter") plotter.SetLegendUpperCenter();
+    else if (name == "upperLeft") plotter.SetLegendUpperLeft();
+    else if (name == "lowerRight") plotter.SetLegendLowerRight();
+    else if (name == "lowerCenter") plotter.SetLegendLowerCenter();
+    else if (name == "lowerLeft") plotter.SetLegendLowerLeft();
+    else throw std::runtime_error("unknown legend position \"" + name + "\"");
+}
+
+// Runs in a worker process; errors are reported by throwing
+void renderPlot(const JsonValue& plot, const LoadedObjects& loaded, const std::string& cacheDir) {
+    std::string output = plot.GetString("output");
+    if (output.empty()) throw std::runtime_error("plot without \"output\"");
+
+    Plotter plotter(output, "", static_cast<int>(plot.GetNumber("width", 800)), static_cast<int>(plot.GetNumber("height", 600)));
+
+    std::string decimation = plot.GetString("decimation", "none");
+    if (decimation == "minmax") plotter.SetDecimation(Plotter::Decimation::MinMax);
+    else if (decimation == "lttb") plotter.SetDecimation(Plotter::Decimation::LTTB);
+    else if (decimation != "none") throw std::runtime_error("unknown decimation \"" + decimation + "\"");
+
+    for (const auto& object : arrayMember(plot, "objects")) {
+        std::string name = object.GetString("name");
+        auto found = loaded.find({object.GetString("file"), name});
+        if (found == loaded.end() || !found->second) throw std::runtime_error(name + " was not loaded");
+
+        addObject(plotter, found->second, object.GetString("label", name), object.GetBool("legend", true), object.GetBool("newColor", true),
+                  object.GetString("draw"));
+    }
+
+    if (plot.Find("title")) plotter.SetTitle(plot.GetString("title"));
+    if (plot.Find("xTitle")) plotter.SetXAxisTitle(plot.GetString("xTitle"));
+    if (plot.Find("yTitle")) plotter.SetYAxisTitle(plot.GetString("yTitle"));
+
+    std::vector<double> xRange = numbers(plot, "xRange", 2);
+    if (!xRange.empty()) plotter.SetXAxisRange(xRange[0], xRange[1]);
+    std::vector<double> yRange = numbers(plot, "yRange", 2);
+    if (!yRange.empty()) plotter.SetYAxisRange(yRange[0], yRange[1]);
+
+    if (plot.Find("font")) plotter.SetFont(static_cast<int>(plot.GetNumber("font")));
+
+    if (const JsonValue* stats = plot.Find("stats")) {
+        if (stats->IsArray()) {
+            std::vector<double> box = numbers(plot, "stats", 4);
+            plotter.ShowStats("on", box[0], box[1], box[2], box[3]);
+        } else {
+            plotter.ShowStats(plot.GetBool("stats") ? "on" : "off");
+        }
+    }
+
+    if (const JsonValue* legend = plot.Find("legend")) applyLegend(plotter, *legend);
+
+    std::vector<std::string> formats = strings(plot, "formats");
+    if (formats.empty()) formats.push_back("png");
+
+    if (!cacheDir.empty()) {
+        plotter.RenderCached(formats, output, cacheDir);
+    } else {
+        plotter.CreatePlot();
+        plotter.Export(formats, output);
+        std::vector<std::string> failed = plotter.FlushExports();
+        if (!failed.empty()) throw std::runtime_error("cannot write " + failed.front());
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    auto usage = [argv] {
+        std::cerr << "Usage: " << argv[0] << " spec.json [--workers n]" << std::endl;
+        return 1;
+    };
+    if (argc < 2) return usage();
+
+    // A worker count given on the command line overrides the spec
+    std::optional<int> workersOption;
+    for (int i = 2; i < argc; ++i) {
+        if (std::string(argv[i]) != "--workers" || i + 1 >= argc) return usage();
+        const char* value = argv[++i];
+        char* end = nullptr;
+        long workers = std::strtol(value, &end, 10);
+        if (end == value || *end != '\0' || workers < 0) return usage();
+        workersOption = static_cast<int>(workers);
+    }
+
+    // Every read of the spec may throw on a member of the wrong type
+    JsonValue spec;
+    int workers = 0;
+    std::string cacheDir;
+    std::vector<std::pair<std::string, const JsonValue*>> plots;
+    LoadedObjects loaded;
+    bool loadedAll;
+    try {
+        spec = ParseJson(readFile(argv[1]));
+        workers = workersOption ? *workersOption : static_cast<int>(spec.GetNumber("workers", 0));
+        cacheDir = spec.GetString("cacheDir");
+        for (const auto& plot : arrayMember(spec, "plots")) {
+            plots.push_back({plot.GetString("output"), &plot});
+        }
+
+        gROOT->SetBatch(kTRUE);
+        loadedAll = loadObjects(spec, loaded);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << argv[1] << ": " << e.what() << std::endl;
+        for (auto& object : loaded) delete object.second;
+        return 1;
+    }
+
+    PlotBatch batch(workers);
+    for (const auto& [output, plot] : plots) {
+        batch.AddJob(output, [plot = plot, &loaded, &cacheDir] { renderPlot(*plot, loaded, cacheDir); });
+    }
+
+    int failures = 0;
+    for (const auto& result : batch.Run()) {
+        if (result.success) {
+            std::cout << result.name << ": done in " << result.seconds << " s" << std::endl;
+        } else {
+            std::cerr << result.name << ": failed: " << result.message << std::endl;
+            failures++;
+        }
+    }
+
+    for (auto& object : loaded) delete object.second;
+
+    return (failures == 0 && loadedAll) ? 0 : 1;
+}
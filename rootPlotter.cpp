@@ -1,212 +1,895 @@
 #include "rootPlotter.h"
 #include <TStyle.h>
+#include <TROOT.h>
+#include <TPaveText.h>
+#include <TDirectory.h>
+#include <TMemFile.h>
+#include <TImage.h>
+
+#include <ROOT/RDataFrame.hxx>
+#include <ROOT/RResultHandle.hxx>
+#include <ROOT/RDFHelpers.hxx>
+
+#include "AsyncFileWriter.h"
+#include "ContentHash.h"
+#include "Decimation.h"
+#include "FunctionSampler.h"
+#include "RangeKernels.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <cstdlib>
+#include <filesystem>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+
+#include <unistd.h>
+
+namespace {
+
+// Set by EnableThreadSafety(), after which plotters no longer write gStyle outside of a save
+std::atomic<bool> threadSafeMode{false};
+
+// Numbers the default canvas names, since TCanvas deletes an existing canvas of the same name
+std::atomic<int> canvasCounter{0};
+
+// Numbers the histograms plotters create, whose names would otherwise repeat across plotters and calls
+std::atomic<unsigned long> histogramCounter{0};
+
+// Image scaling only exists in gStyle, so it is swapped in while a plotter saves an image.
+// Saves with the same scaling share it and run concurrently; a save with another scaling
+// waits until they are done, and the lock is only held while gStyle is changed.
+class ScopedImageScaling {
+public:
+    ScopedImageScaling(double scaling) : scaling(static_cast<float>(scaling)) {
+        State& shared = state();
+        std::unique_lock<std::mutex> lock(shared.mutex);
+        shared.released.wait(lock, [&] { return shared.users == 0 || shared.scaling == this->scaling; });
+        if (shared.users++ == 0) {
+            shared.previous = gStyle->GetImageScaling();
+            shared.scaling = this->scaling;
+            gStyle->SetImageScaling(this->scaling);
+        }
+    }
+    ~ScopedImageScaling() {
+        State& shared = state();
+        std::lock_guard<std::mutex> lock(shared.mutex);
+        if (--shared.users > 0) return;
+        gStyle->SetImageScaling(shared.previous);
+        shared.released.notify_all();
+    }
+
+private:
+    struct State {
+        std::mutex mutex;
+        std::condition_variable released;
+        int users = 0;
+        float scaling = 0;
+        float previous = 0;
+    };
+
+    static State& state() {
+        static State shared;
+        return shared;
+    }
+
+    float scaling;
+};
+
+// Records a phase of the profile that started at start
+void recordPhase(PlotProfile& profile, const char* name, double start) {
+    profile.phases.push_back({name, start, ProfileClock() - start});
+}
+
+// Number of points or bins an object puts on the canvas
+long long drawnPoints(PlotObjectKind kind, TObject* drawn) {
+    switch (kind) {
+        case PlotObjectKind::Histogram: return static_cast<TH1*>(drawn)->GetNbinsX();
+        case PlotObjectKind::Graph:
+        case PlotObjectKind::Function: return static_cast<TGraph*>(drawn)->GetN();
+        case PlotObjectKind::Efficiency: return static_cast<TEfficiency*>(drawn)->GetTotalHistogram()->GetNbinsX();
+    }
+    return 0;
+}
+
+// Read access to the sums of weights TH1 keeps for its statistics. GetStats() would recompute them
+// from every bin whenever they were reset by SetBinContent or an axis range is set.
+struct TH1Sums : TH1 {
+    static double sumw(const TH1* hist) { return hist->*(&TH1Sums::fTsumw); }
+    static double sumw2(const TH1* hist) { return hist->*(&TH1Sums::fTsumw2); }
+};
+
+// Cheap fingerprints used to notice that an object changed since its bounds were cached, all O(1)
+// for histograms. Filling or setting a bin bumps the entry count, Scale, Add and Divide change the
+// sums of weights, and resizing a graph reallocates its arrays. Other changes need MarkModified().
+std::size_t objectRevision(TH1* hist) {
+    const TAxis* axis = hist->GetXaxis();
+    std::size_t revision = std::hash<double>()(hist->GetEntries()) ^ (static_cast<std::size_t>(hist->GetNbinsX()) << 1);
+    revision = (revision * 31) ^ std::hash<double>()(TH1Sums::sumw(hist)) ^ (std::hash<double>()(TH1Sums::sumw2(hist)) << 1);
+    revision = (revision * 31) ^ static_cast<std::size_t>(hist->GetBufferLength());
+    revision = (revision * 31) ^ static_cast<std::size_t>(axis->GetFirst()) ^ (static_cast<std::size_t>(axis->GetLast()) << 16);
+    return revision;
+}
+
+std::size_t objectRevision(TGraph* graph) {
+    const double* x = graph->GetX();
+    const double* y = graph->GetY();
+    int n = graph->GetN();
+    std::size_t revision = std::hash<const void*>()(x) ^ (std::hash<const void*>()(y) << 1) ^ (static_cast<std::size_t>(n) << 2);
+
+    // SetPoint writes in place, so up to 64 evenly spaced points and the last one are checked as well.
+    // Other in-place changes are only seen through MarkModified().
+    int stride = std::max(1, n / 64);
+    for (int i = 0; i < n; i += stride) {
+        revision = (revision * 31) ^ std::hash<double>()(x[i]) ^ (std::hash<double>()(y[i]) << 1);
+    }
+    if (n > 0) revision = (revision * 31) ^ std::hash<double>()(x[n - 1]) ^ (std::hash<double>()(y[n - 1]) << 1);
+    return revision;
+}
+
+std::size_t objectRevision(TEfficiency* eff) {
+    return objectRevision(const_cast<TH1*>(eff->GetTotalHistogram())) ^ (objectRevision(const_cast<TH1*>(eff->GetPassedHistogram())) << 1);
+}
+
+std::size_t objectRevision(TF1* func) {
+    std::size_t revision = std::hash<double>()(func->GetXmin()) ^ (std::hash<double>()(func->GetXmax()) << 1);
+    for (int i = 0; i < func->GetNpar(); ++i) {
+        revision = (revision * 31) ^ std::hash<double>()(func->GetParameter(i));
+    }
+    return revision;
+}
+
+// Bins inside the x axis range of the plot, or the axis' own range when none is set. Taken from the
+// plot rather than the axis, since a borrowed histogram's axis is never changed by the plotter.
+void visibleBins(const TAxis* axis, const std::vector<double>& xRange, int& first, int& last) {
+    first = axis->GetFirst();
+    last = axis->GetLast();
+    if (xRange.empty()) return;
+    int nBins = axis->GetNbins();
+    first = std::clamp(axis->FindFixBin(xRange[0]), 1, nBins);
+    last = std::clamp(axis->FindFixBin(xRange[1]), 1, nBins);
+    if (last > first && axis->GetBinLowEdge(last) >= xRange[1]) last--;
+    if (last < first) std::swap(first, last);
+}
+
+// Bounds over the visible bins, including error bars
+void computeBounds(TH1* hist, const std::vector<double>& xRange, double& xmin, double& xmax, double& ymin, double& ymax) {
+    TAxis* axis = hist->GetXaxis();
+    int first, last;
+    visibleBins(axis, xRange, first, last);
+    xmin = axis->GetBinLowEdge(first);
+    xmax = axis->GetBinUpEdge(last);
+
+    ymin = std::numeric_limits<double>::max();
+    ymax = std::numeric_limits<double>::lowest();
+    for (int bin = first; bin <= last; ++bin) {
+        double content = hist->GetBinContent(bin);
+        double error = hist->GetBinError(bin);
+        ymin = std::min(ymin, content - error);
+        ymax = std::max(ymax, content + error);
+    }
+}
+
+// Bounds of the visible bins read straight from the bin arrays. Only valid when the bin errors are
+// the default sqrt(sumw2) or sqrt(content); returns false otherwise.
+template <typename H>
+bool computeArrayBounds(H* hist, const std::vector<double>& xRange, double& xmin, double& xmax, double& ymin, double& ymax) {
+    if (hist->GetBinErrorOption() != TH1::kNormal) return false;
+    hist->BufferEmpty();
+
+    TAxis* axis = hist->GetXaxis();
+    int first, last;
+    visibleBins(axis, xRange, first, last);
+    xmin = axis->GetBinLowEdge(first);
+    xmax = axis->GetBinUpEdge(last);
+
+    const double* sumw2 = hist->GetSumw2N() ? hist->GetSumw2()->GetArray() : nullptr;
+    HistogramRange(hist->GetArray() + first, sumw2 ? sumw2 + first : nullptr, last - first + 1, ymin, ymax);
+    return true;
+}
+
+void computeBounds(TH1F* hist, const std::vector<double>& xRange, double& xmin, double& xmax, double& ymin, double& ymax) {
+    if (!computeArrayBounds(hist, xRange, xmin, xmax, ymin, ymax)) computeBounds(static_cast<TH1*>(hist), xRange, xmin, xmax, ymin, ymax);
+}
+
+void computeBounds(TH1D* hist, const std::vector<double>& xRange, double& xmin, double& xmax, double& ymin, double& ymax) {
+    if (!computeArrayBounds(hist, xRange, xmin, xmax, ymin, ymax)) computeBounds(static_cast<TH1*>(hist), xRange, xmin, xmax, ymin, ymax);
+}
+
+// Bounds over all points, including symmetric or asymmetric error bars and bands when the graph has them
+void computeBounds(TGraph* graph, const std::vector<double>&, double& xmin, double& xmax, double& ymin, double& ymax) {
+    double* ex = graph->GetEX();
+    double* ey = graph->GetEY();
+    double* exl = ex ? ex : graph->GetEXlow();
+    double* exh = ex ? ex : graph->GetEXhigh();
+    double* eyl = ey ? ey : graph->GetEYlow();
+    double* eyh = ey ? ey : graph->GetEYhigh();
+
+    RangeWithErrors(graph->GetX(), exl, exh, graph->GetN(), xmin, xmax);
+    RangeWithErrors(graph->GetY(), eyl, eyh, graph->GetN(), ymin, ymax);
+}
+
+// Bounds over the visible bins of the efficiency, including its asymmetric errors
+void computeBounds(TEfficiency* eff, const std::vector<double>& xRange, double& xmin, double& xmax, double& ymin, double& ymax) {
+    const TAxis* axis = eff->GetTotalHistogram()->GetXaxis();
+    int first, last;
+    visibleBins(axis, xRange, first, last);
+    xmin = axis->GetBinLowEdge(first);
+    xmax = axis->GetBinUpEdge(last);
+
+    ymin = std::numeric_limits<double>::max();
+    ymax = std::numeric_limits<double>::lowest();
+    for (int bin = first; bin <= last; ++bin) {
+        double value = eff->GetEfficiency(bin);
+        ymin = std::min(ymin, value - eff->GetEfficiencyErrorLow(bin));
+        ymax = std::max(ymax, value + eff->GetEfficiencyErrorUp(bin));
+    }
+}
+
+}
+
+// Histograms booked on an RDataFrame, added to the draw list at their booking position once filled
+struct Plotter::PendingHistogram {
+    ROOT::RDF::RResultPtr<TH1D> result;
+    std::size_t position;
+    int color;
+    std::string drawOption;
+    TLegendEntry* legendEntry;
+};
 
 // private members
 
-std::vector<double> Plotter::getAxisLimits() {
-    double xmin = std::numeric_limits<double>::max();
-    double xmax = std::numeric_limits<double>::lowest();
-    double ymin = std::numeric_limits<double>::max();
-    double ymax = std::numeric_limits<double>::lowest();
-    bool rangeSet = false;
-
-    // Check TH1F objects
-    for (auto hist : th1fs) {
-        if (!rangeSet) {
-            xmin = hist->GetXaxis()->GetBinLowEdge(hist->GetXaxis()->GetFirst());
-            xmax = hist->GetXaxis()->GetBinUpEdge(hist->GetXaxis()->GetLast());
-            ymin = hist->GetMinimum();
-            ymax = hist->GetMaximum();
-            rangeSet = true;
-        } else {
-            xmin = std::min(xmin, hist->GetXaxis()->GetBinLowEdge(hist->GetXaxis()->GetFirst()));
-            xmax = std::max(xmax, hist->GetXaxis()->GetBinUpEdge(hist->GetXaxis()->GetLast()));
-            ymin = std::min(ymin, hist->GetMinimum());
-            ymax = std::max(ymax, hist->GetMaximum());
-        }
+int Plotter::nextColor(bool newColor) {
+    if (newColor) {
+        return settings.plotColors[objectCounter++ % settings.plotColors.size()];
     }
+    return settings.plotColors[(objectCounter - 1) % settings.plotColors.size()];
+}
 
-    // Check TH1D objects
-    for (auto hist : th1ds) {
-        if (!rangeSet) {
-            xmin = hist->GetXaxis()->GetBinLowEdge(hist->GetXaxis()->GetFirst());
-            xmax = hist->GetXaxis()->GetBinUpEdge(hist->GetXaxis()->GetLast());
-            ymin = hist->GetMinimum();
-            ymax = hist->GetMaximum();
-            rangeSet = true;
-        } else {
-            xmin = std::min(xmin, hist->GetXaxis()->GetBinLowEdge(hist->GetXaxis()->GetFirst()));
-            xmax = std::max(xmax, hist->GetXaxis()->GetBinUpEdge(hist->GetXaxis()->GetLast()));
-            ymin = std::min(ymin, hist->GetMinimum());
-            ymax = std::max(ymax, hist->GetMaximum());
-        }
+void Plotter::addEntry(ObjectKind kind, TObject* obj, BoundsUpdater updateBounds, const std::string& name, bool addLegend, int color, const EntryStyle& style,
+                       const std::string& drawOption, Ownership ownership, const Series& series) {
+    drawList.push_back({kind, obj, updateBounds, ObjectBounds(), color, drawOption, ownership, nullptr, series, style});
+
+    if (addLegend) {
+        legend->AddEntry(obj, name.c_str());
     }
 
-    // Check TGraph objects
-    for (auto graph : tgraphs) {
-        if (!rangeSet) {
-            xmin = graph->GetXaxis()->GetXmin();
-            xmax = graph->GetXaxis()->GetXmax();
-            ymin = graph->GetYaxis()->GetXmin();
-            ymax = graph->GetYaxis()->GetXmax();
-            rangeSet = true;
-        } else {
-            xmin = std::min(xmin, graph->GetXaxis()->GetXmin());
-            xmax = std::max(xmax, graph->GetXaxis()->GetXmax());
-            ymin = std::min(ymin, graph->GetYaxis()->GetXmin());
-            ymax = std::max(ymax, graph->GetYaxis()->GetXmax());
-        }
+    getBounds(drawList.back());
+}
+
+void Plotter::applyStyle(TObject* obj, const EntryStyle& style) {
+    if (auto* line = dynamic_cast<TAttLine*>(obj)) {
+        line->SetLineColor(style.lineColor);
+        line->SetLineWidth(style.lineWidth);
     }
+    if (auto* marker = dynamic_cast<TAttMarker*>(obj); marker && style.hasMarkers) {
+        marker->SetMarkerColor(style.markerColor);
+        marker->SetMarkerStyle(style.markerStyle);
+        marker->SetMarkerSize(style.markerSize);
+    }
+    if (auto* fill = dynamic_cast<TAttFill*>(obj); fill && style.hasFill) {
+        fill->SetFillColor(style.fillColor);
+    }
+}
 
-    // Check TGraphErrors objects
-    for (auto graph : tgraphErrors) {
-        if (!rangeSet) {
-            xmin = graph->GetXaxis()->GetXmin();
-            xmax = graph->GetXaxis()->GetXmax();
-            ymin = graph->GetYaxis()->GetXmin();
-            ymax = graph->GetYaxis()->GetXmax();
-            rangeSet = true;
-        } else {
-            xmin = std::min(xmin, graph->GetXaxis()->GetXmin());
-            xmax = std::max(xmax, graph->GetXaxis()->GetXmax());
-            ymin = std::min(ymin, graph->GetYaxis()->GetXmin());
-            ymax = std::max(ymax, graph->GetYaxis()->GetXmax());
+// A borrowed object may be drawn by other plotters too, so a copy of its current state is styled and
+// drawn in its place, and titles and ranges are only set on the copy. Functions are already drawn
+// through their samples, and a reduced graph is already a copy.
+void Plotter::updateBorrowedCopy(DrawEntry& entry) {
+    switch (entry.kind) {
+        case ObjectKind::Histogram: {
+            delete entry.display;
+            TH1* copy = static_cast<TH1*>(entry.object->Clone());
+            copy->SetDirectory(nullptr);
+            entry.display = copy;
+            break;
+        }
+        case ObjectKind::Efficiency: {
+            delete entry.display;
+            TEfficiency* copy = static_cast<TEfficiency*>(entry.object->Clone());
+            copy->SetDirectory(nullptr);
+            entry.display = copy;
+            break;
+        }
+        case ObjectKind::Graph: {
+            if (!entry.display) entry.display = entry.object->Clone();
+            break;
         }
+        case ObjectKind::Function: return;
     }
+    applyStyle(entry.display, entry.style);
+}
 
-    // Check TProfile objects
-    for (auto prof : tprofiles) {
-        if (!rangeSet) {
-            xmin = prof->GetXaxis()->GetBinLowEdge(prof->GetXaxis()->GetFirst());
-            xmax = prof->GetXaxis()->GetBinUpEdge(prof->GetXaxis()->GetLast());
-            ymin = prof->GetMinimum();
-            ymax = prof->GetMaximum();
-            rangeSet = true;
-        } else {
-            xmin = std::min(xmin, prof->GetXaxis()->GetBinLowEdge(prof->GetXaxis()->GetFirst()));
-            xmax = std::max(xmax, prof->GetXaxis()->GetBinUpEdge(prof->GetXaxis()->GetLast()));
-            ymin = std::min(ymin, prof->GetMinimum());
-            ymax = std::max(ymax, prof->GetMaximum());
+// Histogram holding the axes and title of an entry, nullptr for an efficiency that has not been painted yet
+TH1* Plotter::frameHistogram(const DrawEntry& entry) {
+    switch (entry.kind) {
+        case ObjectKind::Histogram: return static_cast<TH1*>(entry.display ? entry.display : entry.object);
+        case ObjectKind::Graph: return static_cast<TGraph*>(entry.display ? entry.display : entry.object)->GetHistogram();
+        case ObjectKind::Function: {
+            if (entry.display) return static_cast<TGraph*>(entry.display)->GetHistogram();
+            return static_cast<TF1*>(entry.object)->GetHistogram();
+        }
+        case ObjectKind::Efficiency: {
+            TGraph* painted = static_cast<TEfficiency*>(entry.display ? entry.display : entry.object)->GetPaintedGraph();
+            return painted ? painted->GetHistogram() : nullptr;
         }
     }
+    return nullptr;
+}
 
-    // Check TF1 objects
-    for (auto func : tf1s) {
-        if (!rangeSet) {
-            xmin = func->GetXmin();
-            xmax = func->GetXmax();
-            ymin = func->GetMinimum();
-            ymax = func->GetMaximum();
-            rangeSet = true;
-        } else {
-            xmin = std::min(xmin, func->GetXmin());
-            xmax = std::max(xmax, func->GetXmax());
-            ymin = std::min(ymin, func->GetMinimum());
-            ymax = std::max(ymax, func->GetMaximum());
+// Size of the frame in pixels, the resolution graphs are reduced to and functions are sampled at
+int Plotter::frameColumns() const {
+    return std::max(1, static_cast<int>(canvas->GetWw() * (1 - marginLeft - marginRight)));
+}
+
+int Plotter::frameRows() const {
+    return std::max(1, static_cast<int>(canvas->GetWh() * (1 - marginBottom - marginTop)));
+}
+
+// Points of sorted x worth drawing. [first, last) is set to the points inside the x axis range and one
+// on either side, so the line reaches the frame edges. When that window holds more than four points per
+// frame column, kept is filled with the indices the decimation mode keeps from it, otherwise left empty.
+void Plotter::reduceVisiblePoints(const double* x, const double* y, int n, int& first, int& last, std::vector<int>& kept) const {
+    first = 0;
+    last = n;
+    if (!settings.xAxisRange.empty()) {
+        first = std::max(0, static_cast<int>(std::lower_bound(x, x + n, settings.xAxisRange[0]) - x) - 1);
+        last = std::min(n, static_cast<int>(std::upper_bound(x, x + n, settings.xAxisRange[1]) - x) + 1);
+    }
+
+    int columns = frameColumns();
+    int visible = last - first;
+    kept.clear();
+    if (visible <= 4 * columns) return;
+
+    kept = (settings.decimation == Decimation::LTTB) ? DecimateLTTB(x + first, y + first, visible, 2 * columns)
+                                                     : DecimateMinMax(x + first, y + first, visible, columns);
+    for (int& i : kept) i += first;
+}
+
+void Plotter::updateDisplayGraph(DrawEntry& entry) {
+    delete entry.display;
+    entry.display = nullptr;
+    if (entry.series.x) {
+        updateSeriesDisplay(entry);
+        return;
+    }
+    if (settings.decimation == Decimation::None) return;
+
+    TGraph* graph = static_cast<TGraph*>(entry.object);
+    int n = graph->GetN();
+    double* x = graph->GetX();
+    double* y = graph->GetY();
+    if (n <= 4 * frameColumns() || !IsSorted(x, n)) return;
+
+    // Drawn as is unless there are several visible points per pixel column of the frame
+    int first = 0;
+    int last = n;
+    std::vector<int> kept;
+    reduceVisiblePoints(x, y, n, first, last, kept);
+    if (kept.empty()) return;
+    int k = kept.size();
+
+    // Build a graph of the same type so error bars and bands are kept
+    double* ex = graph->GetEX();
+    double* ey = graph->GetEY();
+    double* exl = graph->GetEXlow();
+    double* exh = graph->GetEXhigh();
+    double* eyl = graph->GetEYlow();
+    double* eyh = graph->GetEYhigh();
+
+    TGraph* display = nullptr;
+    if (ex || ey) {
+        auto* errors = new TGraphErrors(k);
+        for (int j = 0; j < k; ++j) {
+            int i = kept[j];
+            errors->SetPoint(j, x[i], y[i]);
+            errors->SetPointError(j, ex ? ex[i] : 0, ey ? ey[i] : 0);
+        }
+        display = errors;
+    } else if (exl || eyl) {
+        auto* errors = new TGraphAsymmErrors(k);
+        for (int j = 0; j < k; ++j) {
+            int i = kept[j];
+            errors->SetPoint(j, x[i], y[i]);
+            errors->SetPointError(j, exl ? exl[i] : 0, exh ? exh[i] : 0, eyl ? eyl[i] : 0, eyh ? eyh[i] : 0);
+        }
+        display = errors;
+    } else {
+        display = new TGraph(k);
+        for (int j = 0; j < k; ++j) {
+            display->SetPoint(j, x[kept[j]], y[kept[j]]);
         }
     }
 
-    // If no objects have been added, return default values
-    if (!rangeSet) {
-        return {0.0, 1.0, 0.0, 1.0};
+    // Same look and titles as the original
+    graph->TAttLine::Copy(*display);
+    graph->TAttFill::Copy(*display);
+    graph->TAttMarker::Copy(*display);
+    display->SetTitle(graph->GetTitle());
+    display->GetXaxis()->SetTitle(graph->GetXaxis()->GetTitle());
+    display->GetYaxis()->SetTitle(graph->GetYaxis()->GetTitle());
+
+    entry.display = display;
+}
+
+// A series has no points of its own, so a graph of the points that can be seen is built for every plot
+void Plotter::updateSeriesDisplay(DrawEntry& entry) {
+    getBounds(entry);
+    const Series& series = entry.series;
+    const double* x = series.x;
+    const double* y = series.y;
+    int n = series.n;
+
+    // An unsorted series cannot be windowed or reduced, so all of it is drawn
+    int first = 0;
+    int last = n;
+    std::vector<int> kept;
+    if (series.sorted) reduceVisiblePoints(x, y, n, first, last, kept);
+
+    TGraph* display = nullptr;
+    if (!kept.empty()) {
+        int k = kept.size();
+        display = new TGraph(k);
+        for (int j = 0; j < k; ++j) {
+            display->SetPoint(j, x[kept[j]], y[kept[j]]);
+        }
+    } else {
+        display = new TGraph(last - first, x + first, y + first);
     }
 
-    return {xmin, xmax, ymin, ymax};
+    TGraph* style = static_cast<TGraph*>(entry.object);
+    style->TAttLine::Copy(*display);
+    style->TAttFill::Copy(*display);
+    style->TAttMarker::Copy(*display);
+    display->SetTitle(style->GetTitle());
+
+    entry.display = display;
 }
 
-bool Plotter::isPointInLegend(double x, double y) {
-    if (!legend) return false;
+// Bounds of a series over the caller's arrays. Whether x is sorted is checked at the same time,
+// so the arrays are only read again when they change.
+void Plotter::updateSeriesBounds(DrawEntry& entry) {
+    Series& series = entry.series;
+    ObjectBounds& bounds = entry.bounds;
 
-    // Get legend coordinates in pad coordinates
-    double x1NDC = legend->GetX1NDC();
-    double x2NDC = legend->GetX2NDC();
-    double y1NDC = legend->GetY1NDC();
-    double y2NDC = legend->GetY2NDC();
+    std::size_t revision = std::hash<const void*>()(series.x) ^ (std::hash<const void*>()(series.y) << 1) ^ (static_cast<std::size_t>(series.n) << 2);
+    if (bounds.valid && bounds.revision == revision) return;
 
-    // Get pad ranges
-    std::vector<double> axisLimits = getAxisLimits();
-    double xmin = axisLimits[0];
-    double xmax = axisLimits[1];
-    double ymin = axisLimits[2];
-    double ymax = axisLimits[3];
+    RangeWithErrors(series.x, nullptr, nullptr, series.n, bounds.xmin, bounds.xmax);
+    RangeWithErrors(series.y, nullptr, nullptr, series.n, bounds.ymin, bounds.ymax);
+    series.sorted = IsSorted(series.x, series.n);
+    bounds.revision = revision;
+    bounds.valid = true;
+}
+
+template <typename T>
+void Plotter::updateBounds(DrawEntry& entry) {
+    T* typed = static_cast<T*>(entry.object);
+    ObjectBounds& bounds = entry.bounds;
 
-    // Convert NDC coordinates to user coordinates
-    double x1 = xmin + (xmax - xmin) * x1NDC;
-    double x2 = xmin + (xmax - xmin) * x2NDC;
-    double y1 = ymin + (ymax - ymin) * y1NDC;
-    double y2 = ymin + (ymax - ymin) * y2NDC;
+    std::size_t revision = objectRevision(typed);
+    if (bounds.valid && bounds.revision == revision) return;
 
-    // Check if the point is inside the legend box
-    return (x >= x1 && x <= x2 && y >= y1 && y <= y2);
+    computeBounds(typed, settings.xAxisRange, bounds.xmin, bounds.xmax, bounds.ymin, bounds.ymax);
+    bounds.revision = revision;
+    bounds.valid = true;
 }
 
-bool Plotter::doesLegendCoverObjects() {
-    if (!legend) return false;
+template <>
+void Plotter::updateBounds<TF1>(DrawEntry& entry) {
+    TF1* func = static_cast<TF1*>(entry.object);
+    ObjectBounds& bounds = entry.bounds;
+
+    // Only the part of the function inside the x axis range is sampled
+    double xmin = func->GetXmin();
+    double xmax = func->GetXmax();
+    if (!settings.xAxisRange.empty() && settings.xAxisRange[0] < xmax && settings.xAxisRange[1] > xmin) {
+        xmin = std::max(xmin, settings.xAxisRange[0]);
+        xmax = std::min(xmax, settings.xAxisRange[1]);
+    }
 
-    // Check TH1F objects
-    for (auto hist : th1fs) {
-        for (int bin = 1; bin <= hist->GetNbinsX(); ++bin) {
-            double x = hist->GetXaxis()->GetBinCenter(bin);
-            double y = hist->GetBinContent(bin);
-            if (isPointInLegend(x, y)) return true;
-        }
+    // Resample when the function, the sampled window or the frame size in pixels changes
+    int columns = frameColumns();
+    int rows = frameRows();
+    std::size_t revision = objectRevision(func) ^ (static_cast<std::size_t>(columns) << 16) ^ static_cast<std::size_t>(rows);
+    revision = (revision * 31) ^ std::hash<double>()(xmin) ^ (std::hash<double>()(xmax) << 1);
+    if (bounds.valid && entry.display && bounds.revision == revision) return;
+
+    // Within the window, one sample per frame column covers the whole axis when zoomed in
+    if (!settings.xAxisRange.empty() && settings.xAxisRange[1] > settings.xAxisRange[0]) {
+        columns = std::max(1, static_cast<int>(columns * (xmax - xmin) / (settings.xAxisRange[1] - settings.xAxisRange[0])));
     }
 
-    // Check TH1D objects
-    for (auto hist : th1ds) {
-        for (int bin = 1; bin <= hist->GetNbinsX(); ++bin) {
-            double x = hist->GetXaxis()->GetBinCenter(bin);
-            double y = hist->GetBinContent(bin);
-            if (isPointInLegend(x, y)) return true;
-        }
+    std::vector<double> x;
+    std::vector<double> y;
+    SampleFunction(func, xmin, xmax, columns, rows, settings.nPixels, x, y);
+
+    auto* samples = new TGraph(x.size(), x.data(), y.data());
+    samples->SetTitle(func->GetTitle());
+    delete entry.display;
+    entry.display = samples;
+
+    computeBounds(samples, {}, bounds.xmin, bounds.xmax, bounds.ymin, bounds.ymax);
+    bounds.xmin = func->GetXmin();
+    bounds.xmax = func->GetXmax();
+    bounds.revision = revision;
+    bounds.valid = true;
+}
+
+// Bound computations selected by PlotTraits<T>::BoundsType
+template void Plotter::updateBounds<TH1>(DrawEntry& entry);
+template void Plotter::updateBounds<TH1F>(DrawEntry& entry);
+template void Plotter::updateBounds<TH1D>(DrawEntry& entry);
+template void Plotter::updateBounds<TGraph>(DrawEntry& entry);
+template void Plotter::updateBounds<TEfficiency>(DrawEntry& entry);
+
+const Plotter::ObjectBounds& Plotter::getBounds(DrawEntry& entry) {
+    (this->*entry.updateBounds)(entry);
+    return entry.bounds;
+}
+
+void Plotter::MarkModified(TObject* obj) {
+    for (auto& entry : drawList) {
+        if (!obj || entry.object == obj) entry.bounds.valid = false;
     }
+}
 
-    // Check TGraph objects
-    for (auto graph : tgraphs) {
+std::vector<double> Plotter::getAxisLimits() {
+    double xmin = std::numeric_limits<double>::max();
+    double xmax = std::numeric_limits<double>::lowest();
+    double ymin = std::numeric_limits<double>::max();
+    double ymax = std::numeric_limits<double>::lowest();
+
+    // Merge the cached bounds of every object
+    auto merge = [&](const ObjectBounds& bounds) {
+        xmin = std::min(xmin, bounds.xmin);
+        xmax = std::max(xmax, bounds.xmax);
+        ymin = std::min(ymin, bounds.ymin);
+        ymax = std::max(ymax, bounds.ymax);
+    };
+
+    for (auto& entry : drawList) merge(getBounds(entry));
+
+    // If no objects have been added (or none have finite content), return default values
+    if (xmin > xmax || ymin > ymax) {
+        return {0.0, 1.0, 0.0, 1.0};
+    }
+
+    return {xmin, xmax, ymin, ymax};
+}
+
+void Plotter::buildOccupancyGrid(double xmin, double xmax, double ymin, double ymax) {
+    occupancy.Clear();
+
+    // Map user coordinates to NDC inside the frame
+    double frameWidth = 1 - marginLeft - marginRight;
+    double frameHeight = 1 - marginBottom - marginTop;
+    double xScale = (xmax > xmin) ? frameWidth / (xmax - xmin) : 0;
+    double yScale = (ymax > ymin) ? frameHeight / (ymax - ymin) : 0;
+    auto toNDCX = [&](double x) { return marginLeft + (x - xmin) * xScale; };
+    auto toNDCY = [&](double y) { return marginBottom + (y - ymin) * yScale; };
+
+    // Histograms are drawn as steps with error bars at the bin centers. Bin edges come from the
+    // axis arrays, or fixed-width arithmetic for a uniform axis.
+    auto markHistogram = [&](TH1* hist) {
+        TAxis* axis = hist->GetXaxis();
+        int nBins = hist->GetNbinsX();
+        const double* edges = axis->GetXbins()->GetSize() ? axis->GetXbins()->GetArray() : nullptr;
+        double low = axis->GetXmin();
+        double width = (axis->GetXmax() - low) / nBins;
+        auto lowEdge = [&](int bin) { return edges ? edges[bin - 1] : low + (bin - 1) * width; };
+
+        auto markBins = [&](auto content, auto error) {
+            double previousY = 0;
+            for (int bin = 1; bin <= nBins; ++bin) {
+                double lowX = lowEdge(bin);
+                double upX = lowEdge(bin + 1);
+                double value = content(bin);
+                double spread = error(bin, value);
+                double y = toNDCY(value);
+
+                if (bin > 1) occupancy.MarkSpan(toNDCX(lowX), previousY, y);
+                occupancy.MarkSegment(toNDCX(lowX), y, toNDCX(upX), y);
+                occupancy.MarkSpan(toNDCX((lowX + upX) / 2), toNDCY(value - spread), toNDCY(value + spread));
+                previousY = y;
+            }
+        };
+
+        // TH1F and TH1D with the default errors are read straight from their bin arrays, like
+        // computeArrayBounds; anything else, including derived classes such as TProfile whose arrays
+        // are not the bin contents, goes through the virtual accessors
+        TH1F* histF = (hist->IsA() == TH1F::Class()) ? static_cast<TH1F*>(hist) : nullptr;
+        TH1D* histD = (hist->IsA() == TH1D::Class()) ? static_cast<TH1D*>(hist) : nullptr;
+        if ((histF || histD) && hist->GetBinErrorOption() == TH1::kNormal) {
+            hist->BufferEmpty();
+            const double* sumw2 = hist->GetSumw2N() ? hist->GetSumw2()->GetArray() : nullptr;
+            auto defaultError = [sumw2](int bin, double value) { return sumw2 ? std::sqrt(sumw2[bin]) : std::sqrt(std::abs(value)); };
+            if (histF) {
+                const float* content = histF->GetArray();
+                markBins([content](int bin) { return static_cast<double>(content[bin]); }, defaultError);
+            } else {
+                const double* content = histD->GetArray();
+                markBins([content](int bin) { return content[bin]; }, defaultError);
+            }
+        } else {
+            markBins([hist](int bin) { return hist->GetBinContent(bin); },
+                     [hist](int bin, double) { return hist->GetBinError(bin); });
+        }
+    };
+
+    // Graphs are drawn as markers joined by lines, with error bars or bands when present
+    auto markGraph = [&](TGraph* graph) {
         double* x = graph->GetX();
         double* y = graph->GetY();
+        double* ey = graph->GetEY();
+        double* eyl = ey ? ey : graph->GetEYlow();
+        double* eyh = ey ? ey : graph->GetEYhigh();
         for (int i = 0; i < graph->GetN(); ++i) {
-            if (isPointInLegend(x[i], y[i])) return true;
+            double xNDC = toNDCX(x[i]);
+            double yNDC = toNDCY(y[i]);
+            if (eyl && eyh) occupancy.MarkSpan(xNDC, toNDCY(y[i] - eyl[i]), toNDCY(y[i] + eyh[i]));
+            else occupancy.MarkPoint(xNDC, yNDC);
+            if (i > 0) occupancy.MarkSegment(toNDCX(x[i - 1]), toNDCY(y[i - 1]), xNDC, yNDC);
+        }
+    };
+
+    for (auto& entry : drawList) {
+        switch (entry.kind) {
+            case ObjectKind::Histogram: markHistogram(static_cast<TH1*>(entry.object)); break;
+            case ObjectKind::Graph: {
+                // A series is only drawn through its display graph, built here when no plot was created yet
+                if (entry.series.x && !entry.display) updateDisplayGraph(entry);
+                markGraph(static_cast<TGraph*>(entry.display ? entry.display : entry.object));
+                break;
+            }
+            case ObjectKind::Function: {
+                if (entry.display) markGraph(static_cast<TGraph*>(entry.display));
+                break;
+            }
+            case ObjectKind::Efficiency: {
+                TGraph* painted = static_cast<TEfficiency*>(entry.display ? entry.display : entry.object)->GetPaintedGraph();
+                if (painted) markGraph(painted);
+                break;
+            }
         }
     }
 
-    // Check TGraphErrors objects
-    for (auto graph : tgraphErrors) {
-        double* x = graph->GetX();
-        double* y = graph->GetY();
-        for (int i = 0; i < graph->GetN(); ++i) {
-            if (isPointInLegend(x[i], y[i])) return true;
+    occupancy.Build();
+}
+
+bool Plotter::findFreeLegendPosition() {
+    // Range of legend lower-left corners that keep the legend inside the frame
+    double xlo = marginLeft + 0.02;
+    double xhi = 1 - marginRight - 0.02 - settings.legendWidth;
+    double ylo = marginBottom + 0.02;
+    double yhi = 1 - marginTop - 0.02 - settings.legendHeight;
+    if (xhi < xlo || yhi < ylo) return false;
+
+    double xStep = 1.0 / occupancy.GetNx();
+    double yStep = 1.0 / occupancy.GetNy();
+    int nx = static_cast<int>(std::ceil((xhi - xlo) / xStep));
+    int ny = static_cast<int>(std::ceil((yhi - ylo) / yStep));
+    double xCenter = (xlo + xhi) / 2;
+
+    // Slide the legend over the frame and keep the free position closest to the top or bottom edge,
+    // preferring right, left, then center like the fixed default positions
+    bool found = false;
+    double bestCost = std::numeric_limits<double>::max();
+    double bestX = xhi;
+    double bestY = yhi;
+    for (int j = 0; j <= ny; ++j) {
+        double y = std::max(yhi - j * yStep, ylo);
+        double dy = std::min(yhi - y, (y - ylo) + yStep);
+
+        for (int i = 0; i <= nx; ++i) {
+            double x = std::min(xlo + i * xStep, xhi);
+            double dx = std::min({xhi - x, (x - xlo) + xStep, std::abs(x - xCenter) + 2 * xStep});
+            double cost = 2 * dy + dx;
+            if (cost >= bestCost) continue;
+
+            profile.overlapTests++;
+            if (!occupancy.IsOccupied(x, x + settings.legendWidth, y, y + settings.legendHeight)) {
+                found = true;
+                bestCost = cost;
+                bestX = x;
+                bestY = y;
+            }
+        }
+    }
+
+    if (found) {
+        SetLegendPosition(bestX, bestX + settings.legendWidth, bestY, bestY + settings.legendHeight, false);
+    }
+    return found;
+}
+
+void Plotter::placeLegend(double xmin, double xmax, double ymin, double ymax) {
+    // Undo the expansion of an earlier placement, which no longer fits content that has changed since
+    resetYAxisRange();
+
+    buildOccupancyGrid(xmin, xmax, ymin, ymax);
+    if (findFreeLegendPosition()) return;
+
+    // No free position: compute the smallest y range expansion that clears a strip for the legend,
+    // either above the data (raising ymax) or below it (lowering ymin)
+    double frameHeight = 1 - marginBottom - marginTop;
+    double xlo = marginLeft + 0.02;
+    double xhi = 1 - marginRight - 0.02 - settings.legendWidth;
+    double ylo = marginBottom + 0.02;
+    double yhi = 1 - marginTop - 0.02 - settings.legendHeight;
+
+    // Frame fractions where a legend at the top starts and a legend at the bottom ends
+    double topLegendStart = (yhi - marginBottom) / frameHeight;
+    double bottomLegendEnd = (ylo + settings.legendHeight - marginBottom) / frameHeight;
+
+    if (xhi < xlo || topLegendStart <= 0 || bottomLegendEnd >= 1) {
+        SetLegendUpperRight(false);
+        return;
+    }
+
+    // One grid row of clearance between the data and the legend
+    double clearance = 1.0 / (occupancy.GetNy() * frameHeight);
+
+    double xStep = 1.0 / occupancy.GetNx();
+    int nx = static_cast<int>(std::ceil((xhi - xlo) / xStep));
+
+    double bestScale = std::numeric_limits<double>::max();
+    double bestX = xhi;
+    bool bestTop = true;
+    for (int i = 0; i <= nx; ++i) {
+        double x = std::max(xhi - i * xStep, xlo);
+        profile.rangeAttempts++;
+        double highest = (occupancy.HighestInColumns(x, x + settings.legendWidth) - marginBottom) / frameHeight;
+        double lowest = (occupancy.LowestInColumns(x, x + settings.legendWidth) - marginBottom) / frameHeight;
+
+        // With ymin fixed, content at fraction f moves to f / scale
+        double topScale = (highest + clearance) / topLegendStart;
+        if (topScale < bestScale) {
+            bestScale = topScale;
+            bestX = x;
+            bestTop = true;
+        }
+
+        // With ymax fixed, the distance from the top (1 - f) moves to (1 - f) / scale
+        double bottomScale = (1 - lowest + clearance) / (1 - bottomLegendEnd);
+        if (bottomScale < bestScale) {
+            bestScale = bottomScale;
+            bestX = x;
+            bestTop = false;
         }
     }
 
-    // Check TProfile objects
-    for (auto prof : tprofiles) {
-        for (int bin = 1; bin <= prof->GetNbinsX(); ++bin) {
-            double x = prof->GetXaxis()->GetBinCenter(bin);
-            double y = prof->GetBinContent(bin);
-            if (isPointInLegend(x, y)) return true;
+    bestScale = std::max(bestScale, 1.0);
+    double range = ymax - ymin;
+    if (bestTop) {
+        applyYAxisRange(ymin, ymin + range * bestScale);
+        SetLegendPosition(bestX, bestX + settings.legendWidth, yhi, yhi + settings.legendHeight, false);
+    } else {
+        applyYAxisRange(ymax - range * bestScale, ymax);
+        SetLegendPosition(bestX, bestX + settings.legendWidth, ylo, ylo + settings.legendHeight, false);
+    }
+}
+
+void Plotter::drawLegend() {
+    TList* entries = legend->GetListOfPrimitives();
+    if (!entries) {
+        std::cerr << "Error: Source legend has no entries!" << std::endl;
+        return;
+    }
+
+    // The same copy is refilled on every call instead of allocating a new legend
+    if (!drawnLegend) {
+        drawnLegend = new TLegend(legend->GetX1NDC(), legend->GetY1NDC(), legend->GetX2NDC(), legend->GetY2NDC());
+    } else {
+        drawnLegend->Clear();
+        drawnLegend->SetX1NDC(legend->GetX1NDC());
+        drawnLegend->SetX2NDC(legend->GetX2NDC());
+        drawnLegend->SetY1NDC(legend->GetY1NDC());
+        drawnLegend->SetY2NDC(legend->GetY2NDC());
+    }
+
+    // Iterate through the entries and add them to the drawn legend
+    for (TObject* obj : *entries) {
+        TLegendEntry* entry = dynamic_cast<TLegendEntry*>(obj);
+        if (entry) {
+            // Retrieve the object, label, and option from the entry. A borrowed object is shown through
+            // the styled copy drawn in its place.
+            TObject* object = entry->GetObject();
+            for (const auto& drawEntry : drawList) {
+                if (drawEntry.object == object && drawEntry.ownership == Ownership::Borrowed && drawEntry.display) object = drawEntry.display;
+            }
+            const char* label = entry->GetLabel();
+            const char* option = entry->GetOption();
+
+            // Add the entry to the drawn legend
+            drawnLegend->AddEntry(object, label, option);
         }
     }
 
-    // Check TF1 objects
-    for (auto func : tf1s) {
-        double xmin = func->GetXmin();
-        double xmax = func->GetXmax();
-        int nPoints = 100; // Number of points to check
-        double step = (xmax - xmin) / nPoints;
+    if (settings.textFont >= 0) drawnLegend->SetTextFont(settings.textFont);
+    drawnLegend->Draw();
+}
+
+// Fingerprint of the settings applied while drawing, a change requires a full redraw
+std::size_t Plotter::settingsRevision() const {
+    std::size_t seed = 0;
+    auto combine = [&seed](auto value) {
+        seed ^= std::hash<decltype(value)>()(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    };
+    combine(settings.titleSize);
+    combine(settings.axisSize);
+    combine(settings.axisLabelSize);
+    combine(marginLeft);
+    combine(marginRight);
+    combine(marginBottom);
+    combine(marginTop);
+    combine(settings.nPixels);
+    combine(static_cast<int>(settings.decimation));
+    combine(settings.showLegend);
+    combine(settings.legendWidth);
+    combine(settings.legendHeight);
+    combine(canvas->GetWw());
+    combine(canvas->GetWh());
+    return seed;
+}
+
+// Live mode update of an already drawn canvas. The objects drawn are the ones being updated, so
+// only the legend may need to move before repainting. Returns false when a full redraw is needed.
+bool Plotter::updateLivePlot() {
+    bool changed = false;
+    for (auto& entry : drawList) {
+        bool wasValid = entry.bounds.valid;
+        std::size_t revision = entry.bounds.revision;
+        getBounds(entry);
+        if (wasValid && entry.bounds.revision == revision) continue;
+
+        // Reduced graphs and function samples are copies, they have to be rebuilt and drawn again
+        if (entry.display || (entry.kind == ObjectKind::Graph && settings.decimation != Decimation::None)) return false;
+        changed = true;
+    }
+    if (!changed) return true;
 
-        for (double x = xmin; x <= xmax; x += step) {
-            double y = func->Eval(x);
-            if (isPointInLegend(x, y)) return true;
+    // Legend placement is only rerun when the merged bounds moved
+    std::vector<double> axisLimits = getAxisLimits();
+    if (!settings.manualLegendPosition && axisLimits != drawnLimits) {
+        placeLegend(axisLimits[0], axisLimits[1], axisLimits[2], axisLimits[3]);
+        if (drawnLegend) {
+            drawnLegend->SetX1NDC(legend->GetX1NDC());
+            drawnLegend->SetX2NDC(legend->GetX2NDC());
+            drawnLegend->SetY1NDC(legend->GetY1NDC());
+            drawnLegend->SetY2NDC(legend->GetY2NDC());
         }
     }
+    drawnLimits = axisLimits;
 
-    return false;
+    // Placing the legend goes through the setters, which is not a change made by the user
+    settingsChanged = false;
+
+    canvas->Modified();
+    canvas->Update();
+    return true;
+}
+
+// Delete the drawn copies and owned objects, leaving borrowed objects to their owner
+void Plotter::clearObjects() {
+    for (auto& entry : drawList) {
+        delete entry.display;
+        if (entry.ownership == Ownership::Owned) delete entry.object;
+    }
+    drawList.clear();
+    pendingHistograms.clear();
+    sharedSources.clear();
 }
 
 // public members
 Plotter::Plotter(const std::string& canvasName, const std::string& canvasTitle, int width, int height) {
-    canvas = new TCanvas(canvasName.c_str(), canvasTitle.c_str(), width, height);
+    std::string name = canvasName.empty() ? "canvas_" + std::to_string(canvasCounter++) : canvasName;
+    canvas = new TCanvas(name.c_str(), canvasTitle.c_str(), width, height);
     canvas->SetLeftMargin(marginLeft);
     canvas->SetRightMargin(marginRight);
     canvas->SetBottomMargin(marginBottom);
@@ -216,286 +899,238 @@ Plotter::Plotter(const std::string& canvasName, const std::string& canvasTitle,
 }
 
 Plotter::~Plotter() {
+    // Submitted objects are added first so that owned ones are deleted with the rest
+    addSubmittedObjects();
+
+    // Wait for this plotter's exports, whose failures would otherwise go unreported
+    for (const auto& path : FlushExports()) {
+        std::cerr << "Error: cannot write " << path << std::endl;
+    }
+
     delete canvas;
     delete legend;
-    for (auto hist : th1fs) delete hist;
-    for (auto hist : th1ds) delete hist;
-    for (auto graph : tgraphs) delete graph;
-    for (auto graph : tgraphErrors) delete graph;
-    for (auto prof : tprofiles) delete prof;
-    for (auto func : tf1s) delete func;
+    delete drawnLegend;
+    clearObjects();
+}
+
+void Plotter::Reset() {
+    // Take everything off the pad before deleting it
+    canvas->Clear();
+    addSubmittedObjects();
+    clearObjects();
+
+    delete legend;
+    delete drawnLegend;
+    legend = new TLegend(0.7, 0.7, 0.9, 0.9);
+    drawnLegend = nullptr;
+
+    // Back to the defaults of a new plotter
+    objectCounter = 0;
+    incrementColor = true;
+    settings = {};
+    drawn = false;
+    settingsChanged = true;
+    drawnEntries = 0;
+    drawnLimits.clear();
 }
 
 void Plotter::SetTitle(const std::string& title) {
-    for (auto hist : th1fs) hist->SetTitle(title.c_str());
-    for (auto hist : th1ds) hist->SetTitle(title.c_str());
-    for (auto graph : tgraphs) graph->SetTitle(title.c_str());
-    for (auto graph : tgraphErrors) graph->SetTitle(title.c_str());
-    for (auto prof : tprofiles) prof->SetTitle(title.c_str());
-    for (auto func : tf1s) func->SetTitle(title.c_str());
+    settings.title = title;
+    settingsChanged = true;
+}
+
+void Plotter::SetPalette(const std::vector<int>& colors) {
+    if (colors.empty()) {
+        std::cerr << "Error: the palette needs at least one color" << std::endl;
+        return;
+    }
+    settings.plotColors = colors;
+}
+
+void Plotter::SetPalette(const std::vector<std::string>& hexColors) {
+    std::vector<int> colors;
+    for (const auto& hex : hexColors) {
+        int color = InternHexColor(hex);
+        if (color < 0) {
+            std::cerr << "Error: invalid color " << hex << ", expected #rrggbb" << std::endl;
+            return;
+        }
+        colors.push_back(color);
+    }
+    SetPalette(colors);
+}
+
+std::string Plotter::GetTitle() const {
+    if (settings.title || drawList.empty()) return settings.title.value_or("");
+    return drawList.front().object->GetTitle();
 }
 
 void Plotter::SetXAxisTitle(const std::string& title) {
-    for (auto hist : th1fs) hist->GetXaxis()->SetTitle(title.c_str());
-    for (auto hist : th1ds) hist->GetXaxis()->SetTitle(title.c_str());
-    for (auto graph : tgraphs) graph->GetXaxis()->SetTitle(title.c_str());
-    for (auto graph : tgraphErrors) graph->GetXaxis()->SetTitle(title.c_str());
-    for (auto prof : tprofiles) prof->GetXaxis()->SetTitle(title.c_str());
-    for (auto func : tf1s) func->GetXaxis()->SetTitle(title.c_str());
+    settings.xAxisTitle = title;
+    settingsChanged = true;
 }
 
 void Plotter::SetYAxisTitle(const std::string& title) {
-    for (auto hist : th1fs) hist->GetYaxis()->SetTitle(title.c_str());
-    for (auto hist : th1ds) hist->GetYaxis()->SetTitle(title.c_str());
-    for (auto graph : tgraphs) graph->GetYaxis()->SetTitle(title.c_str());
-    for (auto graph : tgraphErrors) graph->GetYaxis()->SetTitle(title.c_str());
-    for (auto prof : tprofiles) prof->GetYaxis()->SetTitle(title.c_str());
-    for (auto func : tf1s) func->GetYaxis()->SetTitle(title.c_str());
+    settings.yAxisTitle = title;
+    settingsChanged = true;
 }
 
 void Plotter::SetFont(int font) {
-    gStyle->SetTextFont(font);
-    gStyle->SetLabelFont(font, "x");
-    gStyle->SetLabelFont(font, "y");
-    gStyle->SetLabelFont(font, "z");
-    gStyle->SetTitleFont(font, "x");
-    gStyle->SetTitleFont(font, "y");
-    gStyle->SetTitleFont(font, "z");
-    gStyle->SetLegendFont(font);
-    gStyle->SetStatFont(font);
-
-    // Apply to existing objects
-    for (auto hist : th1fs) {
-        hist->GetXaxis()->SetLabelFont(font);
-        hist->GetYaxis()->SetLabelFont(font);
-        hist->GetXaxis()->SetTitleFont(font);
-        hist->GetYaxis()->SetTitleFont(font);
-        hist->SetTitleFont(font);
-    }
-
-    for (auto hist : th1ds) {
-        hist->GetXaxis()->SetLabelFont(font);
-        hist->GetYaxis()->SetLabelFont(font);
-        hist->GetXaxis()->SetTitleFont(font);
-        hist->GetYaxis()->SetTitleFont(font);
-        hist->SetTitleFont(font);
-    }
-
-    for (auto graph : tgraphs) {
-        graph->GetXaxis()->SetLabelFont(font);
-        graph->GetYaxis()->SetLabelFont(font);
-        graph->GetXaxis()->SetTitleFont(font);
-        graph->GetYaxis()->SetTitleFont(font);
-        graph->GetHistogram()->SetTitleFont(font);
-    }
-
-    for (auto graph : tgraphErrors) {
-        graph->GetXaxis()->SetLabelFont(font);
-        graph->GetYaxis()->SetLabelFont(font);
-        graph->GetXaxis()->SetTitleFont(font);
-        graph->GetYaxis()->SetTitleFont(font);
-        graph->GetHistogram()->SetTitleFont(font);
-    }
-
-    for (auto prof : tprofiles) {
-        prof->GetXaxis()->SetLabelFont(font);
-        prof->GetYaxis()->SetLabelFont(font);
-        prof->GetXaxis()->SetTitleFont(font);
-        prof->GetYaxis()->SetTitleFont(font);
-        prof->SetTitleFont(font);
-    }
-
-    for (auto func : tf1s) {
-        func->GetXaxis()->SetLabelFont(font);
-        func->GetYaxis()->SetLabelFont(font);
-        func->GetXaxis()->SetTitleFont(font);
-        func->GetYaxis()->SetTitleFont(font);
-        func->GetHistogram()->SetTitleFont(font);
-    }
-
-    // Apply to legend
-    legend->SetTextFont(font);
-
-    // Update the canvas to show changes
-    canvas->Update();
+    // Only this plotter's objects are changed, gStyle is left alone
+    settings.textFont = font;
+    settingsChanged = true;
 }
 
-void Plotter::AddObject(TH1F* obj, const std::string& name, bool addLegend, bool newColor, std::string drawOption) {
-    th1fs.push_back(obj);
+void Plotter::AddHistogram(ROOT::RDF::RNode df, const std::string& column, const Binning& binning, const std::string& name,
+                           const std::string& cut, const std::string& weight, bool addLegend, bool newColor, std::string drawOption) {
+    ROOT::RDF::RNode filtered = cut.empty() ? df : ROOT::RDF::RNode(df.Filter(cut));
 
-    int color;
-    if (newColor) {
-        color = plotColors[objectCounter % plotColors.size()];
-        objectCounter++;
+    std::string histName = "plotter_" + column + "_" + std::to_string(histogramCounter++);
+    ROOT::RDF::TH1DModel model(histName.c_str(), "", binning.nBins, binning.low, binning.high);
+
+    if (weight.empty()) {
+        AddHistogram(filtered.Histo1D(model, column), name, addLegend, newColor, drawOption);
     } else {
-        color = plotColors[(objectCounter - 1) % plotColors.size()];
+        AddHistogram(filtered.Histo1D(model, column, weight), name, addLegend, newColor, drawOption);
     }
+}
+
+void Plotter::AddHistogram(ROOT::RDF::RResultPtr<TH1D> result, const std::string& name, bool addLegend, bool newColor, std::string drawOption) {
+    int color = nextColor(newColor);
 
     if (drawOption == "") {
-        drawOption = th1fDrawOption;
+        drawOption = settings.drawOptions[static_cast<int>(PlotTraits<TH1D>::slot)];
     }
-    th1fDrawOptions.push_back(drawOption);
-
-    th1fs.back()->SetLineColor(color);
-    th1fs.back()->SetLineWidth(lineWidth);
-
-    th1fs.back()->SetFillColorAlpha(color, fillAlpha);
 
+    // Reserve the legend slot now so entries keep the order objects were added in
+    TLegendEntry* legendEntry = nullptr;
     if (addLegend) {
-        legend->AddEntry(obj, name.c_str());
+        legendEntry = legend->AddEntry(static_cast<TObject*>(nullptr), name.c_str(), "lpf");
     }
+
+    pendingHistograms.push_back({result, drawList.size() + pendingHistograms.size(), color, drawOption, legendEntry});
 }
 
-void Plotter::AddObject(TH1D* obj, const std::string& name, bool addLegend, bool newColor, std::string drawOption) {
-    th1ds.push_back(obj);
+void Plotter::EnableImplicitMT(unsigned int nThreads) {
+    ROOT::EnableImplicitMT(nThreads);
+}
 
-    int color;
-    if (newColor) {
-        color = plotColors[objectCounter % plotColors.size()];
-        objectCounter++;
-    } else {
-        color = plotColors[(objectCounter - 1) % plotColors.size()];
-    }
+void Plotter::resolvePendingHistograms() {
+    if (pendingHistograms.empty()) return;
 
-    if (drawOption == "") {
-        drawOption = th1dDrawOption;
-    }
-    th1dDrawOptions.push_back(drawOption);
+    // Run every booked event loop at once, concurrently when implicit multithreading is enabled
+    std::vector<ROOT::RDF::RResultHandle> handles;
+    for (auto& pending : pendingHistograms) handles.emplace_back(pending.result);
+    ROOT::RDF::RunGraphs(handles);
 
-    th1ds.back()->SetLineColor(color);
-    th1ds.back()->SetLineWidth(lineWidth);
+    // Positions were reserved in booking order, so inserting in that order restores it
+    for (auto& pending : pendingHistograms) {
+        TH1D* hist = static_cast<TH1D*>(pending.result->Clone());
+        hist->SetDirectory(nullptr);
+        EntryStyle style = makeStyle<TH1D>(pending.color);
+        applyStyle(hist, style);
 
-    th1ds.back()->SetFillColorAlpha(color, fillAlpha);
+        DrawEntry entry{ObjectKind::Histogram, hist, &Plotter::updateBounds<TH1D>, ObjectBounds(), pending.color, pending.drawOption, Ownership::Owned};
+        entry.style = style;
+        std::size_t position = std::min(pending.position, drawList.size());
+        getBounds(*drawList.insert(drawList.begin() + position, entry));
 
-    if (addLegend) {
-        legend->AddEntry(obj, name.c_str());
+        if (pending.legendEntry) pending.legendEntry->SetObject(hist);
     }
-}
-
-void Plotter::AddObject(TGraph* obj, const std::string& name, bool addLegend, bool newColor, std::string drawOption) {
-    tgraphs.push_back(obj);
 
-    int color;
-    if (newColor) {
-        color = plotColors[objectCounter % plotColors.size()];
-        objectCounter++;
-    } else {
-        color = plotColors[(objectCounter - 1) % plotColors.size()];
-    }
+    pendingHistograms.clear();
+}
 
-    if (drawOption == "") {
-        drawOption = tgraphDrawOption;
+void Plotter::AddSharedHistogram(const SharedHistogramReader& source, const std::string& name, bool addLegend, bool newColor, std::string drawOption) {
+    if (!source.IsValid()) {
+        std::cerr << "Error: shared histogram source for " << name << " is not open" << std::endl;
+        return;
     }
-    tgraphDrawOptions.push_back(drawOption);
-
-    tgraphs.back()->SetMarkerColorAlpha(color, markerAlpha);
-    tgraphs.back()->SetMarkerStyle(markerStyle);
-    tgraphs.back()->SetMarkerSize(markerSize);
 
-    tgraphs.back()->SetLineColor(color);
-    tgraphs.back()->SetLineWidth(lineWidth);
-
-    if (addLegend) {
-        legend->AddEntry(obj, name.c_str());
-    }
+    TH1D* hist = source.CreateHistogram(name);
+    source.Snapshot(hist);
+    AddObject(hist, name, addLegend, newColor, drawOption);
+    sharedSources.push_back({&source, hist, source.GetRevision()});
 }
 
-void Plotter::AddObject(TGraphErrors* obj, const std::string& name, bool addLegend, bool newColor, std::string drawOption) {
-    tgraphErrors.push_back(obj);
-
-    int color;
-    if (newColor) {
-        color = plotColors[objectCounter % plotColors.size()];
-        objectCounter++;
-    } else {
-        color = plotColors[(objectCounter - 1) % plotColors.size()];
+void Plotter::AddSeries(const double* x, const double* y, int n, const std::string& name, bool addLegend, bool newColor, std::string drawOption) {
+    if (!x || !y || n < 0) {
+        std::cerr << "Error: invalid arrays for series " << name << std::endl;
+        return;
     }
 
+    // Empty graph carrying the style and legend entry, the points stay in the caller's arrays
+    TGraph* styleGraph = new TGraph();
+    int color = nextColor(newColor);
+    EntryStyle style = makeStyle<TGraph>(color);
+    applyStyle(styleGraph, style);
+
     if (drawOption == "") {
-        drawOption = tgraphErrorsDrawOption;
+        drawOption = settings.drawOptions[static_cast<int>(PlotTraits<TGraph>::slot)];
     }
-    tgraphErrorsDrawOptions.push_back(drawOption);
-
-    tgraphErrors.back()->SetMarkerColorAlpha(color, markerAlpha);
-    tgraphErrors.back()->SetMarkerStyle(markerStyle);
-    tgraphErrors.back()->SetMarkerSize(markerSize);
 
-    tgraphErrors.back()->SetLineColor(color);
-    tgraphErrors.back()->SetLineWidth(lineWidth);
-
-    tgraphErrors.back()->SetFillColorAlpha(color, fillAlpha);
-
-    if (addLegend) {
-        legend->AddEntry(obj, name.c_str());
-    }
+    addEntry(ObjectKind::Graph, styleGraph, &Plotter::updateSeriesBounds, name, addLegend, color, style, drawOption, Ownership::Owned, {x, y, n, false});
 }
 
-void Plotter::AddObject(TProfile* obj, const std::string& name, bool addLegend, bool newColor, std::string drawOption) {
-    tprofiles.push_back(obj);
-
-    int color;
-    if (newColor) {
-        color = plotColors[objectCounter % plotColors.size()];
-        objectCounter++;
-    } else {
-        color = plotColors[(objectCounter - 1) % plotColors.size()];
-    }
-
-    if (drawOption == "") {
-        drawOption = tprofileDrawOption;
+void Plotter::AddSample(const double* values, std::size_t n, const std::string& name, const Binning& binning, bool addLegend, bool newColor,
+                        std::string drawOption) {
+    if (binning.nBins < 1 || !(binning.low < binning.high)) {
+        std::cerr << "Error: invalid binning for " << name << std::endl;
+        return;
     }
-    tprofileDrawOptions.push_back(drawOption);
 
-    tprofiles.back()->SetMarkerColorAlpha(color, markerAlpha);
-    tprofiles.back()->SetMarkerStyle(markerStyle);
-    tprofiles.back()->SetMarkerSize(markerSize);
+    SampleCounts counts = BinSample(values, n, binning.nBins, binning.low, binning.high);
 
-    tprofiles.back()->SetLineColor(color);
-    tprofiles.back()->SetLineWidth(lineWidth);
+    std::string histName = "plotter_sample_" + std::to_string(histogramCounter++);
+    TH1D* hist = new TH1D(histName.c_str(), "", binning.nBins, binning.low, binning.high);
+    hist->SetDirectory(nullptr);
+    for (int cell = 0; cell < binning.nBins + 2; ++cell) hist->SetBinContent(cell, counts.bins[cell]);
 
-    tprofiles.back()->SetFillColorAlpha(color, fillAlpha);
+    // SetBinContent drops the statistics, restore the ones TH1::Fill would have accumulated
+    double stats[4] = {counts.inRange, counts.inRange, counts.sumX, counts.sumX2};
+    hist->PutStats(stats);
+    hist->SetEntries(counts.entries);
 
-    if (addLegend) {
-        legend->AddEntry(obj, name.c_str());
-    }
+    AddObject(hist, name, addLegend, newColor, drawOption);
 }
 
-void Plotter::AddObject(TF1* obj, const std::string& name, bool addLegend, bool newColor, std::string drawOption) {
-    tf1s.push_back(obj);
-
-    int color;
-    if (newColor) {
-        color = plotColors[objectCounter % plotColors.size()];
-        objectCounter++;
-    } else {
-        color = plotColors[(objectCounter - 1) % plotColors.size()];
-    }
-
-    if (drawOption == "") {
-        drawOption = tf1DrawOption;
-    }
-    tf1DrawOptions.push_back(drawOption);
+void Plotter::AddSample(const double* values, std::size_t n, const std::string& name, BinRule rule, bool addLegend, bool newColor, std::string drawOption) {
+    Binning binning;
+    ChooseBinning(values, n, rule, binning.nBins, binning.low, binning.high);
+    AddSample(values, n, name, binning, addLegend, newColor, drawOption);
+}
 
-    tf1s.back()->SetLineColor(color);
-    tf1s.back()->SetLineWidth(lineWidth);
+// Add the objects submitted by other threads, returns true if there were any
+bool Plotter::addSubmittedObjects() {
+    std::vector<SubmissionQueue::Item> items = submissions.TakeAll();
+    for (auto& item : items) item.apply();
+    return !items.empty();
+}
 
-    tf1s.back()->SetNpx(nPixels);
+void Plotter::refreshSharedHistograms() {
+    for (auto& shared : sharedSources) {
+        std::uint64_t revision = shared.source->GetRevision();
+        if (revision == shared.revision) continue;
 
-    if (addLegend) {
-        legend->AddEntry(obj, name.c_str());
+        // A failed snapshot keeps the previous one, the next CreatePlot() tries again
+        if (shared.source->Snapshot(shared.hist)) {
+            shared.revision = revision;
+            MarkModified(shared.hist);
+        }
     }
 }
 
 void Plotter::ShowStats(const std::string& on_off, double xmin, double xmax, double ymin, double ymax) {
+    settingsChanged = true;
     if (on_off == "on") {
-        statsBox = true;
-        statsXmin = xmin;
-        statsXmax = xmax;
-        statsYmin = ymin;
-        statsYmax = ymax;
+        settings.statsBox = true;
+        settings.statsXmin = xmin;
+        settings.statsXmax = xmax;
+        settings.statsYmin = ymin;
+        settings.statsYmax = ymax;
     }
     else if (on_off == "off") {
-        statsBox = false;
+        settings.statsBox = false;
     }
     else {
         std::cerr << "Invalid option for stats box. Use 'on' or 'off'." << std::endl;
@@ -504,13 +1139,14 @@ void Plotter::ShowStats(const std::string& on_off, double xmin, double xmax, dou
 }
 
 void Plotter::SetLegendPosition(double xmin, double xmax, double ymin, double ymax, bool hold) {
+    settingsChanged = true;
 
     legend->SetX1NDC(xmin);
     legend->SetX2NDC(xmax);
     legend->SetY1NDC(ymin);
     legend->SetY2NDC(ymax);
 
-    if (hold) { manualLegendPosition = true; }
+    if (hold) { settings.manualLegendPosition = true; }
 }
 
 // Set default legend positions
@@ -518,317 +1154,519 @@ void Plotter::SetLegendUpperRight(bool hold) {
     double xmax = 1 - marginRight - 0.02;
     double ymax = 1 - marginTop - 0.02;
 
-    double xmin = xmax - legendWidth;
-    double ymin = ymax - legendHeight;
+    double xmin = xmax - settings.legendWidth;
+    double ymin = ymax - settings.legendHeight;
 
     Plotter::SetLegendPosition(xmin, xmax, ymin, ymax, false);
 
-    if (hold) { manualLegendPosition = true; }
+    if (hold) { settings.manualLegendPosition = true; }
 }
 
 void Plotter::SetLegendUpperCenter(bool hold) {
-    double x_center = marginLeft + (1 - marginLeft - marginRight - legendWidth) / 2;
+    double x_center = marginLeft + (1 - marginLeft - marginRight - settings.legendWidth) / 2;
 
     double xmin = x_center;
-    double xmax = xmin + legendWidth;
+    double xmax = xmin + settings.legendWidth;
 
     double ymax = 1 - marginTop - 0.02;
-    double ymin = ymax - legendHeight;
+    double ymin = ymax - settings.legendHeight;
 
     Plotter::SetLegendPosition(xmin, xmax, ymin, ymax, false);
 
-    if (hold) { manualLegendPosition = true; }
+    if (hold) { settings.manualLegendPosition = true; }
 }
 
 void Plotter::SetLegendUpperLeft(bool hold) {
     double xmin = marginLeft + 0.02;
     double ymax = 1 - marginTop - 0.02;
 
-    double xmax = xmin + legendWidth;
-    double ymin = ymax - legendHeight;
+    double xmax = xmin + settings.legendWidth;
+    double ymin = ymax - settings.legendHeight;
 
     Plotter::SetLegendPosition(xmin, xmax, ymin, ymax, false);
 
-    if (hold) { manualLegendPosition = true; }
+    if (hold) { settings.manualLegendPosition = true; }
 }
 
 void Plotter::SetLegendLowerRight(bool hold) {
     double xmax = 1 - marginRight - 0.02;
     double ymin = marginBottom + 0.02;
 
-    double xmin = xmax - legendWidth;
-    double ymax = ymin + legendHeight;
+    double xmin = xmax - settings.legendWidth;
+    double ymax = ymin + settings.legendHeight;
 
     Plotter::SetLegendPosition(xmin, xmax, ymin, ymax, false);
 
-    if (hold) { manualLegendPosition = true; }
+    if (hold) { settings.manualLegendPosition = true; }
 }
 
 void Plotter::SetLegendLowerCenter(bool hold) {
-    double x_center = marginLeft + (1 - marginLeft - marginRight - legendWidth) / 2;
+    double x_center = marginLeft + (1 - marginLeft - marginRight - settings.legendWidth) / 2;
 
     double xmin = x_center;
-    double xmax = xmin + legendWidth;
+    double xmax = xmin + settings.legendWidth;
 
     double ymin = marginBottom + 0.02;
-    double ymax = ymin + legendHeight;
+    double ymax = ymin + settings.legendHeight;
 
     Plotter::SetLegendPosition(xmin, xmax, ymin, ymax, false);
 
-    if (hold) { manualLegendPosition = true; }
+    if (hold) { settings.manualLegendPosition = true; }
 }
 
 void Plotter::SetLegendLowerLeft(bool hold) {
     double xmin = marginLeft + 0.02;
     double ymin = marginBottom + 0.02;
 
-    double xmax = xmin + legendWidth;
-    double ymax = ymin + legendHeight;
+    double xmax = xmin + settings.legendWidth;
+    double ymax = ymin + settings.legendHeight;
 
     Plotter::SetLegendPosition(xmin, xmax, ymin, ymax, false);
 
     canvas->Update();
 
-    if (hold) { manualLegendPosition = true; }
+    if (hold) { settings.manualLegendPosition = true; }
+}
+
+void Plotter::PlaceLegend() {
+    std::vector<double> axisLimits = getAxisLimits();
+    placeLegend(axisLimits[0], axisLimits[1], axisLimits[2], axisLimits[3]);
 }
 
 void Plotter::SetXAxisRange(double xmin, double xmax) {
-    for (auto hist : th1fs) hist->GetXaxis()->SetRangeUser(xmin, xmax);
-    for (auto hist : th1ds) hist->GetXaxis()->SetRangeUser(xmin, xmax);
-    for (auto graph : tgraphs) graph->GetXaxis()->SetRangeUser(xmin, xmax);
-    for (auto graph : tgraphErrors) graph->GetXaxis()->SetRangeUser(xmin, xmax);
-    for (auto prof : tprofiles) prof->GetXaxis()->SetRangeUser(xmin, xmax);
-    for (auto func : tf1s) func->GetXaxis()->SetRangeUser(xmin, xmax);
+    settings.xAxisRange = {xmin, xmax};
+    settingsChanged = true;
+    // Histogram bounds only cover the bins inside the range
+    MarkModified();
 }
 
 void Plotter::SetYAxisRange(double ymin, double ymax) {
-    for (auto hist : th1fs) hist->GetYaxis()->SetRangeUser(ymin, ymax);
-    for (auto hist : th1ds) hist->GetYaxis()->SetRangeUser(ymin, ymax);
-    for (auto graph : tgraphs) graph->GetYaxis()->SetRangeUser(ymin, ymax);
-    for (auto graph : tgraphErrors) graph->GetYaxis()->SetRangeUser(ymin, ymax);
-    for (auto prof : tprofiles) prof->GetYaxis()->SetRangeUser(ymin, ymax);
-    for (auto func : tf1s) func->GetYaxis()->SetRangeUser(ymin, ymax);
+    settings.yAxisRange = {ymin, ymax};
+    settingsChanged = true;
+}
+
+// Back to the y range set through SetYAxisRange(), or to automatic limits when there is none
+void Plotter::resetYAxisRange() {
+    for (auto& entry : drawList) {
+        TH1* frame = frameHistogram(entry);
+        if (!frame) continue;
+        if (!settings.yAxisRange.empty()) {
+            frame->GetYaxis()->SetRangeUser(settings.yAxisRange[0], settings.yAxisRange[1]);
+        } else {
+            frame->SetMinimum();
+            frame->SetMaximum();
+        }
+    }
+}
+
+void Plotter::applyYAxisRange(double ymin, double ymax) {
+    for (auto& entry : drawList) {
+        if (TH1* frame = frameHistogram(entry)) frame->GetYaxis()->SetRangeUser(ymin, ymax);
+    }
 }
 
 void Plotter::CreatePlot() {
-    if (objectCounter == 0) {
+    profile.Clear();
+    profile.plot = canvas->GetName();
+    profile.thread = ProfileThread();
+    profile.start = ProfileClock();
+
+    // Single-threaded callers may save through GetPlot()->SaveAs(), which reads the scaling from gStyle
+    if (!threadSafeMode) gStyle->SetImageScaling(settings.imageScaling);
+
+    drawPlot();
+
+    profile.duration = ProfileClock() - profile.start;
+    if (tracing) traceProfiles.push_back(profile);
+}
+
+void Plotter::drawPlot() {
+    bool added = addSubmittedObjects();
+    added = !pendingHistograms.empty() || added;
+    double phaseStart = ProfileClock();
+    resolvePendingHistograms();
+    recordPhase(profile, "ResolvePendingHistograms", phaseStart);
+
+    phaseStart = ProfileClock();
+    refreshSharedHistograms();
+    recordPhase(profile, "RefreshSharedHistograms", phaseStart);
+
+    if (drawList.empty()) {
         std::cout << "Nothing to draw!" << std::endl;
         return;
     }
 
+    // In live mode, what is already on the canvas is kept unless objects or settings were added or changed
+    std::size_t settingsNow = settingsRevision();
+    if (settings.liveMode && drawn && !added && !settingsChanged && drawList.size() == drawnEntries && settingsNow == drawnSettings) {
+        phaseStart = ProfileClock();
+        bool updated = updateLivePlot();
+        recordPhase(profile, "LiveUpdate", phaseStart);
+        if (updated) {
+            profile.incremental = true;
+            return;
+        }
+    }
+
+    // Start from an empty pad so that drawing again does not stack copies of the primitives
+    canvas->Clear();
+    canvas->cd();
+
     // Draw all objects on the same canvas
     bool first = true;
 
     TPaveStats* stats = nullptr;
 
-    gStyle->SetImageScaling(3.0);
+    // Draw objects in the order they were added
+    phaseStart = ProfileClock();
+    for (auto& entry : drawList) {
+        if (entry.kind == ObjectKind::Graph) updateDisplayGraph(entry);
+        bool borrowed = entry.ownership == Ownership::Borrowed;
+        if (borrowed) updateBorrowedCopy(entry);
 
-    // Draw TH1F objects
-    for (int i=0; i<th1fs.size(); i++) {
-        th1fs[i]->Draw(first ? th1fDrawOptions[i].c_str() : (th1fDrawOptions[i]+drawSame).c_str() );
-        th1fs[i]->SetTitleSize(titleSize);
-        th1fs[i]->SetTitleSize(axisSize, "x");
-        th1fs[i]->SetTitleSize(axisSize, "y");
-        th1fs[i]->SetLabelSize(axisLabelSize, "x");
-        th1fs[i]->SetLabelSize(axisLabelSize, "y");
+        if (settings.title) {
+            if (!borrowed) static_cast<TNamed*>(entry.object)->SetTitle(settings.title->c_str());
+            if (entry.display) static_cast<TNamed*>(entry.display)->SetTitle(settings.title->c_str());
+        }
 
-        if (first && statsBox) {
+        // Functions are drawn as a line through their cached samples, with the function's current look
+        std::string option = entry.drawOption;
+        if (entry.kind == ObjectKind::Function) {
+            getBounds(entry);
+            TF1* func = static_cast<TF1*>(entry.object);
+            TGraph* samples = static_cast<TGraph*>(entry.display);
+            func->TAttLine::Copy(*samples);
+            func->TAttFill::Copy(*samples);
+            func->TAttMarker::Copy(*samples);
+            if (borrowed) applyStyle(samples, entry.style);
+            if (option.empty()) option = "L";
+        }
+
+        // Everything but histograms needs its axes drawn explicitly when it comes first
+        if (first && entry.kind != ObjectKind::Histogram) option = drawAxes + option;
+        if (!first) option += drawSame;
+        TObject* drawn = entry.display ? entry.display : entry.object;
+        drawn->Draw(option.c_str());
+        profile.objectsDrawn++;
+        profile.pointsDrawn += drawnPoints(entry.kind, drawn);
+
+        // An efficiency only builds its graph when painted
+        TH1* frame = frameHistogram(entry);
+        if (!frame) {
             canvas->Update();
-            stats = (TPaveStats*)th1fs[i]->GetListOfFunctions()->FindObject("stats");
-            gStyle->SetOptFit( 1111 );
-            if (stats) {
-                stats->SetX1NDC(statsXmin);
-                stats->SetX2NDC(statsXmax);
-                stats->SetY1NDC(statsYmin);
-                stats->SetY2NDC(statsYmax);
-            }
-        } else if (!statsBox) {
-            th1fs[i]->SetStats(0);
+            frame = frameHistogram(entry);
+        }
+        if (!frame) {
+            first = false;
+            continue;
         }
-        first = false;
-    }
 
-    // Draw TH1D objects
-    for (int i=0; i<th1ds.size(); i++) {
-        th1ds[i]->Draw(first ? th1dDrawOptions[i].c_str() : (th1dDrawOptions[i]+drawSame).c_str() );
-        th1ds[i]->SetTitleSize(titleSize);
-        th1ds[i]->SetTitleSize(axisSize, "x");
-        th1ds[i]->SetTitleSize(axisSize, "y");
-        th1ds[i]->SetLabelSize(axisLabelSize, "x");
-        th1ds[i]->SetLabelSize(axisLabelSize, "y");
+        frame->SetTitleSize(settings.titleSize);
+        frame->SetTitleSize(settings.axisSize, "x");
+        frame->SetTitleSize(settings.axisSize, "y");
+        frame->SetLabelSize(settings.axisLabelSize, "x");
+        frame->SetLabelSize(settings.axisLabelSize, "y");
 
-        if (first && statsBox) {
-            canvas->Update();
-            stats = (TPaveStats*)th1ds[i]->FindObject("stats");
-            gStyle->SetOptFit( 1111 );
-            if (stats) {
-                stats->SetX1NDC(statsXmin);
-                stats->SetX2NDC(statsXmax);
-                stats->SetY1NDC(statsYmin);
-                stats->SetY2NDC(statsYmax);
+        if (settings.xAxisTitle) frame->GetXaxis()->SetTitle(settings.xAxisTitle->c_str());
+        if (settings.yAxisTitle) frame->GetYaxis()->SetTitle(settings.yAxisTitle->c_str());
+        if (!settings.xAxisRange.empty()) {
+            frame->GetXaxis()->SetRangeUser(settings.xAxisRange[0], settings.xAxisRange[1]);
+        }
+        if (!settings.yAxisRange.empty()) frame->GetYaxis()->SetRangeUser(settings.yAxisRange[0], settings.yAxisRange[1]);
+
+        if (settings.textFont >= 0) {
+            frame->GetXaxis()->SetLabelFont(settings.textFont);
+            frame->GetYaxis()->SetLabelFont(settings.textFont);
+            frame->GetXaxis()->SetTitleFont(settings.textFont);
+            frame->GetYaxis()->SetTitleFont(settings.textFont);
+        }
+
+        if (entry.kind == ObjectKind::Histogram) {
+            if (first && settings.statsBox) {
+                double statsStart = ProfileClock();
+                canvas->Update();
+                stats = (TPaveStats*)frame->GetListOfFunctions()->FindObject("stats");
+                if (stats) {
+                    stats->SetOptFit(settings.optFit);
+                    if (settings.textFont >= 0) stats->SetTextFont(settings.textFont);
+                    stats->SetX1NDC(settings.statsXmin);
+                    stats->SetX2NDC(settings.statsXmax);
+                    stats->SetY1NDC(settings.statsYmin);
+                    stats->SetY2NDC(settings.statsYmax);
+                }
+                recordPhase(profile, "StatsBox", statsStart);
+            } else if (!settings.statsBox) {
+                frame->SetStats(0);
             }
-            canvas->Update();
-        } else if (!statsBox) {
-            th1ds[i]->SetStats(0);
         }
 
         first = false;
     }
+    recordPhase(profile, "DrawObjects", phaseStart);
 
-    // Draw TGraph objects
-    for (int i=0; i<tgraphs.size(); i++) {
-        tgraphs[i]->Draw(first ? (drawAxes+tgraphDrawOptions[i]).c_str() : (tgraphDrawOptions[i]+drawSame).c_str() );
-        tgraphs[i]->GetHistogram()->SetTitleSize(titleSize);
-        tgraphs[i]->GetHistogram()->SetTitleSize(axisSize, "x");
-        tgraphs[i]->GetHistogram()->SetTitleSize(axisSize, "y");
-        tgraphs[i]->GetHistogram()->SetLabelSize(axisLabelSize, "x");
-        tgraphs[i]->GetHistogram()->SetLabelSize(axisLabelSize, "y");
-
-        first = false;
+    // Automatically place legend if it hasn't been manually positioned
+    phaseStart = ProfileClock();
+    std::vector<double> axisLimits = getAxisLimits();
+    if (!settings.manualLegendPosition) {
+        placeLegend(axisLimits[0], axisLimits[1], axisLimits[2], axisLimits[3]);
     }
+    recordPhase(profile, "PlaceLegend", phaseStart);
 
-    // Draw TGraphErrors objects
-    for (int i=0; i<tgraphErrors.size(); i++) {
-        tgraphErrors[i]->Draw(first ? (drawAxes+tgraphErrorsDrawOptions[i]).c_str() : (tgraphErrorsDrawOptions[i]+drawSame).c_str() );
-        tgraphErrors[i]->GetHistogram()->SetTitleSize(titleSize);
-        tgraphErrors[i]->GetHistogram()->SetTitleSize(axisSize, "x");
-        tgraphErrors[i]->GetHistogram()->SetTitleSize(axisSize, "y");
-        tgraphErrors[i]->GetHistogram()->SetLabelSize(axisLabelSize, "x");
-        tgraphErrors[i]->GetHistogram()->SetLabelSize(axisLabelSize, "y");
+    phaseStart = ProfileClock();
+    if (settings.showLegend) drawLegend();
 
-        first = false;
+    if (stats) {
+        stats->Draw();
     }
+    recordPhase(profile, "DrawLegend", phaseStart);
 
-    // Draw TProfile objects
-    for (int i=0; i<tprofiles.size(); i++) {
-        tprofiles[i]->Draw(first ? (tprofileDrawOptions[i]).c_str() : (tprofileDrawOptions[i]+drawSame).c_str() );
-        tprofiles[i]->SetTitleSize(titleSize);
-        tprofiles[i]->SetTitleSize(axisSize, "x");
-        tprofiles[i]->SetTitleSize(axisSize, "y");
-        tprofiles[i]->SetLabelSize(axisLabelSize, "x");
-        tprofiles[i]->SetLabelSize(axisLabelSize, "y");
+    phaseStart = ProfileClock();
+    canvas->Update();
 
-        first = false;
+    // The title box only exists once the pad has been painted
+    if (settings.textFont >= 0) {
+        TPaveText* titleBox = dynamic_cast<TPaveText*>(canvas->GetPrimitive("title"));
+        if (titleBox) {
+            titleBox->SetTextFont(settings.textFont);
+            canvas->Modified();
+            canvas->Update();
+        }
     }
+    recordPhase(profile, "CanvasUpdate", phaseStart);
 
-    // Draw TF1 objects
-    for (int i=0; i<tf1s.size(); i++) {
-        tf1s[i]->Draw(first ? tf1DrawOptions[i].c_str() : (tf1DrawOptions[i]+drawSame).c_str() );
-        tf1s[i]->GetHistogram()->SetTitleSize(titleSize);
-        tf1s[i]->GetHistogram()->SetTitleSize(axisSize, "x");
-        tf1s[i]->GetHistogram()->SetTitleSize(axisSize, "y");
-        tf1s[i]->GetHistogram()->SetLabelSize(axisLabelSize, "x");
-        tf1s[i]->GetHistogram()->SetLabelSize(axisLabelSize, "y");
+    drawn = true;
+    settingsChanged = false;
+    drawnEntries = drawList.size();
+    drawnSettings = settingsNow;
+    drawnLimits = axisLimits;
+}
 
-        first = false;
-    }
+void Plotter::SaveAs(const std::string& filename) {
+    ScopedImageScaling scaling(settings.imageScaling);
+    canvas->SaveAs(filename.c_str());
+}
 
-    // Automatically place legend if it hasn't been manually positioned
-    if (!manualLegendPosition) {
-        // Split legend positions into upper and lower
-        std::vector<std::function<void(bool)>> upperLegendPositions = {
-            [this](bool h) { this->SetLegendUpperRight(h); },
-            [this](bool h) { this->SetLegendUpperLeft(h); },
-            [this](bool h) { this->SetLegendUpperCenter(h); }
-        };
-        std::vector<std::function<void(bool)>> lowerLegendPositions = {
-            [this](bool h) { this->SetLegendLowerRight(h); },
-            [this](bool h) { this->SetLegendLowerLeft(h); },
-            [this](bool h) { this->SetLegendLowerCenter(h); }
-        };
+void Plotter::Export(const std::vector<std::string>& formats, const std::string& basename) {
+    if (exportTicket == 0) exportTicket = AsyncFileWriter::Shared().NewTicket();
+    exportTo(exportTicket, formats, basename);
+}
+
+void Plotter::exportTo(AsyncFileWriter::Ticket ticket, const std::vector<std::string>& formats, const std::string& basename) {
+    AsyncFileWriter& writer = AsyncFileWriter::Shared();
 
-        // Get the current pad's y range
-        std::vector<double> axisLimits = getAxisLimits();
-        double originalYmin = axisLimits[2];
-        double originalYmax = axisLimits[3];
-        double ymin = originalYmin;
-        double ymax = originalYmax;
-
-        bool legendCoversObjects = true;
-        int positionAttempts = 0;
-        int rangeAttempts = 0;
-
-        // First try different positions at original scale
-        for (auto& setPosition : upperLegendPositions) {
-            setPosition(false);
-            legendCoversObjects = doesLegendCoverObjects();
-            if (!legendCoversObjects) break;
-        }
-        if (legendCoversObjects) {
-            for (auto& setPosition : lowerLegendPositions) {
-                setPosition(false);
-                legendCoversObjects = doesLegendCoverObjects();
-                if (!legendCoversObjects) break;
+    // Raster formats share a single paint of the canvas into an image
+    std::unique_ptr<TImage> image;
+
+    for (const auto& format : formats) {
+        std::string path = basename + "." + format;
+
+        if (format == "root") {
+            // Serialize and compress in memory, only the disk write is left to the writer thread
+            TDirectory::TContext context;
+            TMemFile memFile(path.c_str(), "RECREATE");
+            canvas->Write();
+            memFile.Write();
+
+            std::vector<char> data(memFile.GetSize());
+            memFile.CopyTo(data.data(), data.size());
+            memFile.Close();
+
+            writer.Write(ticket, path, std::move(data));
+        } else if (format == "png" || format == "jpg" || format == "jpeg" || format == "gif" || format == "tiff" || format == "bmp") {
+            if (!image) {
+                ScopedImageScaling scaling(settings.imageScaling);
+                image.reset(TImage::Create());
+                image->FromPad(canvas);
             }
-        }
 
-        // If no suitable position found, start alternating between increasing ymax and ymin
-        while (legendCoversObjects && rangeAttempts < 10) {
-            if (rangeAttempts % 2 == 0) {
-                // Try increasing ymax
-                ymax = originalYmax * (1.0 + (0.1 * ((rangeAttempts/2) + 1)));
-                ymin = originalYmin;
-                SetYAxisRange(ymin, ymax);
-
-                // Check upper positions
-                for (auto& setPosition : upperLegendPositions) {
-                    setPosition(false);
-                    legendCoversObjects = doesLegendCoverObjects();
-                    if (!legendCoversObjects) {
-                        break;
-                    }
+            // PNG can be encoded into a buffer and written in the background, the others are written directly
+            if (format == "png") {
+                char* buffer = nullptr;
+                int size = 0;
+                image->GetImageBuffer(&buffer, &size, TImage::kPng);
+                if (buffer) {
+                    writer.Write(ticket, path, std::vector<char>(buffer, buffer + size));
+                    free(buffer);
                 }
             } else {
-                // Try increasing ymin
-                ymin = originalYmin * (1.0 + (0.1 * ((rangeAttempts/2) + 1)));
-                ymax = originalYmax;
-                SetYAxisRange(ymin, ymax);
-
-                // Check lower positions
-                for (auto& setPosition : lowerLegendPositions) {
-                    setPosition(false);
-                    legendCoversObjects = doesLegendCoverObjects();
-                    if (!legendCoversObjects) {
-                        break;
-                    }
-                }
+                image->WriteImage(path.c_str());
             }
-
-            if (!legendCoversObjects) break;
-            rangeAttempts++;
+        } else {
+            // Vector formats are painted by ROOT straight into their output file
+            SaveAs(path);
         }
     }
+}
 
-    if (showLegend) {
-        auto * legendtodraw = new TLegend(legend->GetX1NDC(), legend->GetY1NDC(), legend->GetX2NDC(), legend->GetY2NDC());
-
-        TList* entries = legend->GetListOfPrimitives();
-        if (!entries) {
-            std::cerr << "Error: Source legend has no entries!" << std::endl;
-            return;
+std::string Plotter::GetContentHash() {
+    addSubmittedObjects();
+    resolvePendingHistograms();
+
+    ContentHash hash;
+    // Changed whenever the rendering itself changes, so that older cached files are not reused
+    hash.Add("rootPlotter render 1");
+
+    for (auto& entry : drawList) {
+        hash.Add(static_cast<int>(entry.kind));
+        switch (entry.kind) {
+            case ObjectKind::Histogram: hash.AddContents(static_cast<TH1*>(entry.object)); break;
+            case ObjectKind::Graph: hash.AddContents(static_cast<TGraph*>(entry.object)); break;
+            case ObjectKind::Function: {
+                TF1* func = static_cast<TF1*>(entry.object);
+                hash.AddContents(func);
+                // A function built from C++ code has no formula to hash, so hash the samples drawn for it
+                if (func->GetExpFormula().IsNull()) {
+                    getBounds(entry);
+                    hash.AddContents(static_cast<TGraph*>(entry.display));
+                }
+                break;
+            }
+            case ObjectKind::Efficiency: hash.AddContents(static_cast<TEfficiency*>(entry.object)); break;
+        }
+        if (entry.series.x) {
+            hash.Add(entry.series.n);
+            hash.Add(entry.series.x, entry.series.n * sizeof(double));
+            hash.Add(entry.series.y, entry.series.n * sizeof(double));
         }
+        hash.AddAttributes(entry.object);
+        hash.AddColor(entry.color);
+        // Style given by this plotter, which only the drawn copy carries for a borrowed object
+        hash.Add(entry.ownership == Ownership::Borrowed);
+        hash.AddColor(entry.style.lineColor);
+        hash.Add(entry.style.lineWidth);
+        hash.AddColor(entry.style.markerColor);
+        hash.Add(entry.style.markerStyle);
+        hash.Add(entry.style.markerSize);
+        hash.AddColor(entry.style.fillColor);
+        hash.Add(entry.drawOption);
+    }
 
-        // Iterate through the entries and add them to the target legend
+    // Legend
+    hash.Add(settings.showLegend);
+    if (TList* entries = legend->GetListOfPrimitives()) {
         for (TObject* obj : *entries) {
-            TLegendEntry* entry = dynamic_cast<TLegendEntry*>(obj);
-            if (entry) {
-                // Retrieve the object, label, and option from the entry
-                TObject* object = entry->GetObject();
-                const char* label = entry->GetLabel();
-                const char* option = entry->GetOption();
-
-                // Add the entry to the target legend
-                legendtodraw->AddEntry(object, label, option);
+            if (TLegendEntry* entry = dynamic_cast<TLegendEntry*>(obj)) {
+                hash.Add(entry->GetLabel());
+                hash.Add(entry->GetOption());
             }
         }
+    }
+    hash.Add(settings.manualLegendPosition);
+    if (settings.manualLegendPosition) {
+        hash.Add(legend->GetX1NDC());
+        hash.Add(legend->GetX2NDC());
+        hash.Add(legend->GetY1NDC());
+        hash.Add(legend->GetY2NDC());
+    }
+    hash.Add(settings.legendWidth);
+    hash.Add(settings.legendHeight);
 
-        legendtodraw->Draw();
+    // Titles and ranges
+    for (const auto* text : {&settings.title, &settings.xAxisTitle, &settings.yAxisTitle}) {
+        hash.Add(text->has_value());
+        hash.Add(text->value_or(""));
+    }
+    for (const auto* range : {&settings.xAxisRange, &settings.yAxisRange}) {
+        hash.Add(static_cast<int>(range->size()));
+        for (double limit : *range) hash.Add(limit);
     }
 
-    if (stats) {
-        stats->Draw();
+    // Style
+    hash.Add(settings.textFont);
+    hash.Add(settings.optFit);
+    hash.Add(settings.imageScaling);
+    hash.Add(settings.titleSize);
+    hash.Add(settings.axisSize);
+    hash.Add(settings.axisLabelSize);
+    hash.Add(marginLeft);
+    hash.Add(marginRight);
+    hash.Add(marginBottom);
+    hash.Add(marginTop);
+    hash.Add(settings.nPixels);
+    hash.Add(static_cast<int>(settings.decimation));
+    hash.Add(settings.statsBox);
+    if (settings.statsBox) {
+        hash.Add(settings.statsXmin);
+        hash.Add(settings.statsXmax);
+        hash.Add(settings.statsYmin);
+        hash.Add(settings.statsYmax);
     }
 
-    canvas->Update();
+    // Canvas, including pad settings made directly through GetPlot()
+    hash.Add(static_cast<int>(canvas->GetWw()));
+    hash.Add(static_cast<int>(canvas->GetWh()));
+    hash.Add(canvas->GetLogx());
+    hash.Add(canvas->GetLogy());
+    hash.Add(canvas->GetLogz());
+    hash.Add(canvas->GetGridx());
+    hash.Add(canvas->GetGridy());
+    hash.Add(canvas->GetTickx());
+    hash.Add(canvas->GetTicky());
+
+    return hash.Hex();
+}
+
+bool Plotter::RenderCached(const std::vector<std::string>& formats, const std::string& basename, const std::string& cacheDir) {
+    namespace fs = std::filesystem;
+    std::string cacheBase = (fs::path(cacheDir) / GetContentHash()).string();
+
+    auto copyFromCache = [&]() {
+        for (const auto& format : formats) {
+            std::error_code error;
+            fs::copy_file(cacheBase + "." + format, basename + "." + format, fs::copy_options::overwrite_existing, error);
+            if (error) {
+                std::cerr << "Error: cannot copy " << cacheBase << "." << format << " to " << basename << "." << format << ": " << error.message() << std::endl;
+                return false;
+            }
+        }
+        return true;
+    };
+
+    bool cached = std::all_of(formats.begin(), formats.end(), [&](const std::string& format) {
+        std::error_code error;
+        return fs::exists(cacheBase + "." + format, error);
+    });
+    if (cached && copyFromCache()) return true;
+
+    std::error_code error;
+    fs::create_directories(cacheDir, error);
+    if (error) {
+        std::cerr << "Error: cannot create cache directory " << cacheDir << ": " << error.message() << std::endl;
+    }
+
+    // Files are exported under a temporary name and renamed once complete, so an interrupted run never
+    // leaves a partial file in the cache. The name is unique to this call, since other threads and
+    // processes may be rendering the same hash at the same time.
+    static std::atomic<unsigned long> renderCounter{0};
+    std::string tempBase = cacheBase + ".tmp" + std::to_string(getpid()) + "." + std::to_string(renderCounter++);
+    CreatePlot();
+
+    // Waits only for this render's writes, leaving those of earlier Export() calls to FlushExports()
+    AsyncFileWriter& writer = AsyncFileWriter::Shared();
+    AsyncFileWriter::Ticket ticket = writer.NewTicket();
+    exportTo(ticket, formats, tempBase);
+    std::vector<std::string> failed = writer.Flush(ticket);
+
+    for (const auto& format : formats) {
+        std::string tempPath = tempBase + "." + format;
+        if (std::find(failed.begin(), failed.end(), tempPath) != failed.end()) continue;
+        fs::rename(tempPath, cacheBase + "." + format, error);
+        if (error) fs::remove(tempPath, error);
+    }
+
+    copyFromCache();
+    return false;
+}
+
+std::vector<std::string> Plotter::FlushExports() {
+    if (exportTicket == 0) return {};
+    std::vector<std::string> failed = AsyncFileWriter::Shared().Flush(exportTicket);
+    exportTicket = 0;
+    return failed;
+}
 
+void Plotter::EnableThreadSafety() {
+    threadSafeMode = true;
+    ROOT::EnableThreadSafety();
+    gROOT->SetBatch(kTRUE);
 }
@@ -2,12 +2,7 @@
 #define ROOT_PLOTTER_H
 
 #include "TColor.h"
-#include <TH1F.h>
-#include <TH1D.h>
-#include <TGraph.h>
-#include <TGraphErrors.h>
-#include <TProfile.h>
-#include <TF1.h>
+#include "PlotTraits.h"
 
 #include <TCanvas.h>
 #include <TLegend.h>
@@ -15,60 +10,159 @@
 #include "TList.h"
 #include <TPaveStats.h>
 
+#include "AsyncFileWriter.h"
+#include "ColorCache.h"
+#include "OccupancyGrid.h"
+#include "PlotProfile.h"
+#include "SampleHistogram.h"
+#include "SharedHistogram.h"
+#include "SubmissionQueue.h"
+
+#include <array>
+#include <cstddef>
+#include <optional>
 #include <string>
 #include <vector>
 
+// Only declared here, so that including the plotter does not pull in RDataFrame. Callers of the
+// AddHistogram overloads taking a dataframe include ROOT/RDataFrame.hxx themselves.
+namespace ROOT {
+namespace Detail::RDF {
+class RNodeBase;
+}
+namespace RDF {
+template <typename Proxied, typename DataSource>
+class RInterface;
+using RNode = RInterface<::ROOT::Detail::RDF::RNodeBase, void>;
+template <typename T>
+class RResultPtr;
+}
+}
+
 class Plotter {
 public:
-    // Constructor
-    Plotter(const std::string& canvasName = "canvas", const std::string& canvasTitle = "", int width = 800, int height = 600);
+    // Constructor, an empty canvas name is replaced by a unique one so that plotters never share a canvas
+    Plotter(const std::string& canvasName = "", const std::string& canvasTitle = "", int width = 800, int height = 600);
     // Destructor
     ~Plotter();
 
     // Get color vector
-    std::vector<int> GetColors() { return plotColors; }
+    std::vector<int> GetColors() { return settings.plotColors; }
+
+    // Replace the palette new objects take their colors from, as ROOT color indices or "#rrggbb" strings.
+    // Transparent variants of palette colors are created once per process and shared by all plotters.
+    void SetPalette(const std::vector<int>& colors);
+    void SetPalette(const std::vector<std::string>& hexColors);
 
-    // Titles
+    // Titles, axis titles, ranges and the font are only recorded by their setters and applied
+    // to the objects in a single pass when CreatePlot() is called
     void SetTitle(const std::string& title);
+    // Title given to SetTitle(), or the title of the first object
+    std::string GetTitle() const;
     void SetXAxisTitle(const std::string& title);
     void SetYAxisTitle(const std::string& title);
 
-    void SetTitleSize(double size) { titleSize = size; }
-    void SetAxisSize(double size) { axisSize = size; }
-    void SetAxisLabelSize(double size) { axisLabelSize = size; }
+    void SetTitleSize(double size) { settings.titleSize = size; }
+    void SetAxisSize(double size) { settings.axisSize = size; }
+    void SetAxisLabelSize(double size) { settings.axisLabelSize = size; }
 
-    //Set Font
+    //Set Font, applied to this plotter's axes, title, legend and stats box only
     void SetFont(int font=102);
 
-    // Method declarations (moved to source file)
-    void AddObject(TH1F* obj, const std::string& name, bool addLegend = true, bool newColor = true, std::string drawOption = "");
-    void AddObject(TH1D* obj, const std::string& name, bool addLegend = true, bool newColor = true, std::string drawOption = "");
-    void AddObject(TGraph* obj, const std::string& name, bool addLegend = true, bool newColor = true, std::string drawOption = "");
-    void AddObject(TGraphErrors* obj, const std::string& name, bool addLegend = true, bool newColor = true, std::string drawOption = "");
-    void AddObject(TProfile* obj, const std::string& name, bool addLegend = true, bool newColor = true, std::string drawOption = "");
-    void AddObject(TF1* obj, const std::string& name, bool addLegend = true, bool newColor = true, std::string drawOption = "");
+    // Image scaling used when saving raster formats through SaveAs and Export. Outside of thread-safe
+    // mode CreatePlot() also sets it in gStyle, so GetPlot()->SaveAs() keeps using it; in thread-safe
+    // mode only this plotter's SaveAs and Export apply it.
+    void SetImageScaling(double scaling) { settings.imageScaling = scaling; }
+
+    // Whether the plotter deletes an added object. A borrowed object can be shared between plotters,
+    // it must stay alive until the plotter is reset or destroyed. It is never changed by the plotter:
+    // its style, title and ranges are applied to a copy drawn in its place at every CreatePlot().
+    enum class Ownership { Owned, Borrowed };
+
+    // Add any TH1, TGraph, TF1 or TEfficiency; styling and draw option defaults come from PlotTraits<T>
+    template <typename T>
+    void AddObject(T* obj, const std::string& name, bool addLegend = true, bool newColor = true, std::string drawOption = "",
+                   Ownership ownership = Ownership::Owned);
+
+    // AddObject for producer threads, safe to call concurrently without locking. Objects are added by the
+    // next CreatePlot() on the owning thread, sorted by order and then name, so colors and legend order
+    // do not depend on thread timing.
+    template <typename T>
+    void SubmitObject(T* obj, const std::string& name, std::uint64_t order, bool addLegend = true, bool newColor = true, std::string drawOption = "",
+                      Ownership ownership = Ownership::Owned);
+
+    // Binning of a histogram booked on an RDataFrame
+    struct Binning {
+        int nBins;
+        double low;
+        double high;
+    };
+
+    // Book a histogram of a column, with an optional cut expression and weight column. Nothing is read
+    // until CreatePlot(), which fills every booked histogram in a single event loop per dataframe,
+    // running the loops of different dataframes concurrently.
+    void AddHistogram(ROOT::RDF::RNode df, const std::string& column, const Binning& binning, const std::string& name,
+                      const std::string& cut = "", const std::string& weight = "", bool addLegend = true, bool newColor = true, std::string drawOption = "");
+    // Add a histogram already booked by the caller, also filled when CreatePlot() is called
+    void AddHistogram(ROOT::RDF::RResultPtr<TH1D> result, const std::string& name, bool addLegend = true, bool newColor = true, std::string drawOption = "");
+
+    // Add a histogram published by another process through shared memory. A consistent snapshot is copied
+    // in at every CreatePlot(), so the source must outlive the plotter or the next Reset().
+    void AddSharedHistogram(const SharedHistogramReader& source, const std::string& name, bool addLegend = true, bool newColor = true, std::string drawOption = "");
+
+    // Add a series drawn straight from caller-owned arrays of n points, such as columns of a memory-mapped file.
+    // No copy of the arrays is made: bounds are computed over them, and every CreatePlot() builds a small graph
+    // of only the points that can be seen, those inside the x axis range reduced to the frame width with the
+    // decimation mode (MinMax when decimation is off). Unsorted x values cannot be reduced and are copied whole.
+    // The arrays must outlive the plotter or the next Reset(); call MarkModified() after changing them.
+    void AddSeries(const double* x, const double* y, int n, const std::string& name, bool addLegend = true, bool newColor = true,
+                   std::string drawOption = "");
+
+    // Histogram an unbinned sample of n values. The values are binned in parallel into per-thread partial
+    // histograms instead of one TH1::Fill per value, and are only read during the call.
+    void AddSample(const double* values, std::size_t n, const std::string& name, const Binning& binning, bool addLegend = true, bool newColor = true,
+                   std::string drawOption = "");
+    // Same, with the binning chosen from the sample by the Freedman-Diaconis or Scott rule
+    void AddSample(const double* values, std::size_t n, const std::string& name, BinRule rule = BinRule::FreedmanDiaconis, bool addLegend = true,
+                   bool newColor = true, std::string drawOption = "");
+
+    // Enable implicit multithreading for the event loops, must be called before the RDataFrames are created
+    static void EnableImplicitMT(unsigned int nThreads = 0);
+
+    // Invalidate the cached bounds of an object modified after it was added (nullptr for all objects)
+    void MarkModified(TObject* obj = nullptr);
 
     // Methods to set style properties
-    void SetMarker(int style, int size, double alpha) { markerStyle = style; markerSize = size; markerAlpha = alpha; }
-    void SetLineWidth(int width) { lineWidth = width; }
-    void SetFillAlpha(double alpha) { fillAlpha = alpha; }
-    void SetNPixels(int pixels) { nPixels = pixels; }
+    void SetMarker(int style, int size, double alpha) { settings.markerStyle = style; settings.markerSize = size; settings.markerAlpha = alpha; }
+    void SetLineWidth(int width) { settings.lineWidth = width; }
+    void SetFillAlpha(double alpha) { settings.fillAlpha = alpha; }
+    // Maximum number of evaluations when sampling a TF1, which starts from one sample per frame column
+    void SetNPixels(int pixels) { settings.nPixels = pixels; }
+
+    // Optional reduction of large graphs to what the canvas width can show, applied at draw time.
+    // The added graph is left untouched; a reduced copy is drawn in its place. With SetXAxisRange
+    // only the points in the visible window are reduced, so zooming in keeps the full detail.
+    enum class Decimation { None, MinMax, LTTB };
+    void SetDecimation(Decimation mode) { settings.decimation = mode; }
 
     // Method to set draw options
-    void SetTH1FDrawOption(const std::string& option) { th1fDrawOption = option; }
-    void SetTH1DDrawOption(const std::string& option) { th1dDrawOption = option; }
-    void SetTGraphDrawOption(const std::string& option) { tgraphDrawOption = option; }
-    void SetTGraphErrorsDrawOption(const std::string& option) { tgraphErrorsDrawOption = option; }
-    void SetTProfileDrawOption(const std::string& option) { tprofileDrawOption = option; }
-    void SetTF1DrawOption(const std::string& option) { tf1DrawOption = option; }
+    template <typename T>
+    void SetDrawOption(const std::string& option) { settings.drawOptions[static_cast<int>(PlotTraits<T>::slot)] = option; }
+
+    void SetTH1FDrawOption(const std::string& option) { SetDrawOption<TH1F>(option); }
+    void SetTH1DDrawOption(const std::string& option) { SetDrawOption<TH1D>(option); }
+    void SetTGraphDrawOption(const std::string& option) { SetDrawOption<TGraph>(option); }
+    void SetTGraphErrorsDrawOption(const std::string& option) { SetDrawOption<TGraphErrors>(option); }
+    void SetTProfileDrawOption(const std::string& option) { SetDrawOption<TProfile>(option); }
+    void SetTF1DrawOption(const std::string& option) { SetDrawOption<TF1>(option); }
 
     // Method to interact with stats box
     void ShowStats(const std::string& on_off="off", double xmin=0.7, double xmax=0.9, double ymin=0.6, double ymax=0.9);
 
     // Method to set legend position
-    void ShowLegend(bool show) { showLegend = show; }
+    void ShowLegend(bool show) { settings.showLegend = show; }
     void SetLegendPosition(double xmin, double xmax, double ymin, double ymax, bool hold=true);
-    void SetLegendSize(double width, double height) { legendWidth = width; legendHeight = height; }
+    void SetLegendSize(double width, double height) { settings.legendWidth = width; settings.legendHeight = height; }
 
     // Legend default locations
     void SetLegendUpperRight(bool hold=true);
@@ -82,25 +176,126 @@ public:
     void SetXAxisRange(double xmin, double xmax);
     void SetYAxisRange(double ymin, double ymax);
 
+    // Merged limits of all added objects, {xmin, xmax, ymin, ymax}
+    std::vector<double> GetAxisLimits() { return getAxisLimits(); }
+
+    // Run the automatic legend placement on the current objects, as CreatePlot() does
+    void PlaceLegend();
+
     // Method to create the plot
     void CreatePlot();
 
+    // Timings and counters of the last CreatePlot()
+    const PlotProfile& GetProfile() const { return profile; }
+
+    // Keep the profile of every CreatePlot() from now on, and write them as Chrome trace-event JSON
+    void EnableTrace(bool on = true) { tracing = on; }
+    bool WriteTrace(const std::string& filename) const { return WritePlotTrace(filename, traceProfiles); }
+
+    // Live mode, for plots whose objects keep being updated and CreatePlot() is called repeatedly:
+    // the drawn primitives and legend are kept, the canvas is only repainted when an object changed,
+    // and the legend is only moved again when the axis limits changed.
+    // Changes are noticed from a histogram's entries and sums of weights (Fill, SetBinContent, Scale,
+    // Add, Divide, Reset) and from a graph's size, arrays and a sample of its points. Anything these
+    // miss, e.g. SetBinError or SetPoint away from the sampled points, needs MarkModified(obj).
+    void SetLiveMode(bool live) { settings.liveMode = live; }
+
     // Method to get the plot
     TCanvas* GetPlot() { return canvas; }
 
+    // Remove all objects, legend entries and style settings, keeping the canvas for the next plot.
+    // Owned objects are deleted, borrowed ones are left to their owner.
+    void Reset();
+
+    // Save the plot with this plotter's image scaling
+    void SaveAs(const std::string& filename);
+
+    // Save the plot as basename.<format> for each format (e.g. {"png", "pdf", "svg", "root"}).
+    // Raster formats share one paint of the canvas, and PNG and ROOT files are written to disk
+    // by a background thread; call FlushExports() before relying on the files being complete.
+    void Export(const std::vector<std::string>& formats, const std::string& basename);
+    // Wait for the background writes of this plotter's exports only, returns the paths that failed
+    std::vector<std::string> FlushExports();
+
+    // Stable hash of everything that determines the rendered plot: object contents, draw options,
+    // colors (by RGBA) and attributes, titles, fonts, ranges, legend settings, canvas size and the
+    // log, grid and tick settings of the pad. Functions without a formula are hashed by their samples.
+    // Histograms booked on an RDataFrame are filled first, since their contents are part of it.
+    std::string GetContentHash();
+
+    // Export through a cache directory holding cacheDir/<hash>.<format>. If every format is already
+    // cached the files are copied to basename.<format> without drawing; otherwise the plot is created,
+    // exported into the cache and copied. Returns true when the cached files were reused.
+    bool RenderCached(const std::vector<std::string>& formats, const std::string& basename, const std::string& cacheDir);
+
+    // Thread-safe mode: enables ROOT's internal locking and batch graphics so that independent
+    // Plotters can build, draw and save plots concurrently, one Plotter per thread. Canvas names
+    // must differ between the plotters, which the default name guarantees.
+    // Must be called once, before any Plotter is created.
+    static void EnableThreadSafety();
+
 private:
     int objectCounter = 0;
     bool incrementColor = true;
 
     // Colors
-    std::vector<int> plotColors = {
+    static constexpr std::array<int, 15> defaultColors = {
         kPink-3, kAzure-7, kOrange+7, kGreen+1, kBlue+2, kViolet, kGray+3, kAzure+7, kYellow-4, kCyan-3, kMagenta-9, kRed, kTeal-8, kOrange+10, kRed-6
     };
 
-    //Axis and title text size defaults
-    double titleSize = 0.07;
-    double axisSize = 0.05;
-    double axisLabelSize = 0.03;
+    // Everything chosen through the setters, with the defaults of a new plotter. Reset() restores them
+    // by assigning a default Settings.
+    struct Settings {
+        std::vector<int> plotColors{defaultColors.begin(), defaultColors.end()};
+
+        // Titles and ranges requested through the setters, applied to the objects by CreatePlot()
+        std::optional<std::string> title;
+        std::optional<std::string> xAxisTitle;
+        std::optional<std::string> yAxisTitle;
+        std::vector<double> xAxisRange;
+        std::vector<double> yAxisRange;
+
+        // Style state owned by this plotter instead of gStyle, a negative font keeps ROOT's default
+        int textFont = -1;
+        int optFit = 1111;
+        double imageScaling = 3.0;
+
+        //Axis and title text size defaults
+        double titleSize = 0.07;
+        double axisSize = 0.05;
+        double axisLabelSize = 0.03;
+
+        // Marker and line styles
+        int markerStyle = 20;
+        double markerSize = 1;
+        double markerAlpha = 0.95;
+
+        int lineWidth = 2;
+
+        double fillAlpha = 0.5;
+
+        double nPixels = 2800;
+
+        Decimation decimation = Decimation::None;
+
+        std::array<std::string, kNumDrawOptionSlots> drawOptions = DefaultDrawOptions();
+
+        // Stats box settings
+        bool statsBox = false;
+        double statsXmin = 0.7;
+        double statsXmax = 0.9;
+        double statsYmin = 0.6;
+        double statsYmax = 0.9;
+
+        // Legend settings
+        bool showLegend = true;
+        bool manualLegendPosition = false;
+        double legendWidth = 0.3;
+        double legendHeight = 0.2;
+
+        bool liveMode = false;
+    };
+    Settings settings;
 
     // Margin Defaults
     double marginLeft = 0.12;
@@ -108,66 +303,191 @@ private:
     double marginBottom = 0.16;
     double marginTop = 0.07;
 
-    // Marker and line styles
-    int markerStyle = 20;
-    double markerSize = 1;
-    double markerAlpha = 0.95;
+    // Cached data bounds of an object, recomputed only when the object changes
+    struct ObjectBounds {
+        double xmin = 0;
+        double xmax = 1;
+        double ymin = 0;
+        double ymax = 1;
+        std::size_t revision = 0;
+        bool valid = false;
+    };
+
+    // Recomputes the bounds of an entry if its object changed, chosen at compile time from PlotTraits<T>::BoundsType
+    struct DrawEntry;
+    using BoundsUpdater = void (Plotter::*)(DrawEntry& entry);
+
+    // Points of a series added with AddSeries(), owned by the caller
+    struct Series {
+        const double* x;
+        const double* y;
+        int n;
+        bool sorted;
+    };
+
+    // Style given to an object when added: applied to the object itself when owned, and to the copy
+    // drawn in its place when borrowed
+    struct EntryStyle {
+        int lineColor = 1;
+        int lineWidth = 1;
+        bool hasMarkers = false;
+        int markerColor = 1;
+        int markerStyle = 1;
+        double markerSize = 1;
+        bool hasFill = false;
+        int fillColor = 0;
+    };
 
-    int lineWidth = 2;
+    // One object to draw, kept in the order it was added
+    using ObjectKind = PlotObjectKind;
+    struct DrawEntry {
+        ObjectKind kind;
+        TObject* object;
+        BoundsUpdater updateBounds;
+        ObjectBounds bounds;
+        int color;
+        std::string drawOption;
+        Ownership ownership;
+
+        // Reduced copy (large graphs), adaptive sampling (functions) or styled copy (borrowed objects)
+        // drawn instead of the object, owned by the plotter
+        TObject* display = nullptr;
+
+        // Set for a series, whose object is an empty graph holding only its style and legend entry
+        Series series = {};
+
+        EntryStyle style;
+    };
+    std::vector<DrawEntry> drawList;
 
-    double fillAlpha = 0.5;
+    // Histograms booked on an RDataFrame, defined with the dataframe types in rootPlotter.cpp
+    struct PendingHistogram;
+    std::vector<PendingHistogram> pendingHistograms;
 
-    double nPixels = 2800;
+    // Objects submitted by other threads, added on the owning thread
+    SubmissionQueue submissions;
 
-    // vectors to hold histograms and other objects
-    std::vector<TH1F*> th1fs;
-    std::vector<TH1D*> th1ds;
-    std::vector<TGraph*> tgraphs;
-    std::vector<TGraphErrors*> tgraphErrors;
-    std::vector<TProfile*> tprofiles;
-    std::vector<TF1*> tf1s;
+    // Histograms refreshed from shared memory, with the source revision they were last copied at
+    struct SharedSource {
+        const SharedHistogramReader* source;
+        TH1D* hist;
+        std::uint64_t revision;
+    };
+    std::vector<SharedSource> sharedSources;
 
     // draw option strings
     std::string drawSame = " SAME";
     std::string drawAxes = "A";
-    std::string th1fDrawOption = "EH";
-    std::string th1dDrawOption = "EH";
-    std::string tgraphDrawOption = "PL";
-    std::string tgraphErrorsDrawOption = "PL E3";
-    std::string tprofileDrawOption = "PL E3";
-    std::string tf1DrawOption = "";
-
-    std::vector<std::string> th1fDrawOptions;
-    std::vector<std::string> th1dDrawOptions;
-    std::vector<std::string> tgraphDrawOptions;
-    std::vector<std::string> tgraphErrorsDrawOptions;
-    std::vector<std::string> tprofileDrawOptions;
-    std::vector<std::string> tf1DrawOptions;
-
-    // Stats box settings
-    bool statsBox = false;
-    double statsXmin = 0.7;
-    double statsXmax = 0.9;
-    double statsYmin = 0.6;
-    double statsYmax = 0.9;
 
     // Canvas for the plotter
     TCanvas* canvas = nullptr;
 
     // Legend for the plotter
-    bool showLegend = true;
-    bool manualLegendPosition = false;
     TLegend* legend = nullptr;
 
-    // Legend location options
-    double legendWidth = 0.3;
-    double legendHeight = 0.2;
+    // Copy of the legend drawn on the canvas, reused by every CreatePlot()
+    TLegend* drawnLegend = nullptr;
+
+    // Ticket of the background writes queued by Export() since the last FlushExports(), 0 when none
+    AsyncFileWriter::Ticket exportTicket = 0;
+
+    // Occupancy of the drawn content in NDC, used for automatic legend placement
+    OccupancyGrid occupancy;
+
+    // Profiling of CreatePlot()
+    PlotProfile profile;
+    bool tracing = false;
+    std::vector<PlotProfile> traceProfiles;
+
+    // What the last CreatePlot() drew, to redraw only what changed in live mode
+    bool drawn = false;
+    bool settingsChanged = true;
+    std::size_t drawnEntries = 0;
+    std::size_t drawnSettings = 0;
+    std::vector<double> drawnLimits;
 
     // Private methods
+    int nextColor(bool newColor);
+    void addEntry(ObjectKind kind, TObject* obj, BoundsUpdater updateBounds, const std::string& name, bool addLegend, int color, const EntryStyle& style,
+                  const std::string& drawOption, Ownership ownership, const Series& series = {});
+    void clearObjects();
+    static TH1* frameHistogram(const DrawEntry& entry);
+    template <typename T>
+    EntryStyle makeStyle(int color) const;
+    static void applyStyle(TObject* obj, const EntryStyle& style);
+    void updateBorrowedCopy(DrawEntry& entry);
+    void resolvePendingHistograms();
+    void refreshSharedHistograms();
+    bool addSubmittedObjects();
+    int frameColumns() const;
+    int frameRows() const;
+    void reduceVisiblePoints(const double* x, const double* y, int n, int& first, int& last, std::vector<int>& kept) const;
+    void updateDisplayGraph(DrawEntry& entry);
+    void updateSeriesDisplay(DrawEntry& entry);
+    void updateSeriesBounds(DrawEntry& entry);
+
+    template <typename T>
+    void updateBounds(DrawEntry& entry);
+    const ObjectBounds& getBounds(DrawEntry& entry);
     std::vector<double> getAxisLimits();
 
-    bool isPointInLegend(double x, double y);
-    bool doesLegendCoverObjects();
+    void buildOccupancyGrid(double xmin, double xmax, double ymin, double ymax);
+    bool findFreeLegendPosition();
+    void placeLegend(double xmin, double xmax, double ymin, double ymax);
+    void resetYAxisRange();
+    void applyYAxisRange(double ymin, double ymax);
+
+    void drawPlot();
+    std::size_t settingsRevision() const;
+    bool updateLivePlot();
+    void drawLegend();
+    void exportTo(AsyncFileWriter::Ticket ticket, const std::vector<std::string>& formats, const std::string& basename);
 };
 
+template <typename T>
+void Plotter::AddObject(T* obj, const std::string& name, bool addLegend, bool newColor, std::string drawOption, Ownership ownership) {
+    using Traits = PlotTraits<T>;
+
+    int color = nextColor(newColor);
+    EntryStyle style = makeStyle<T>(color);
+    if (ownership == Ownership::Owned) applyStyle(obj, style);
+
+    if (drawOption == "") {
+        drawOption = settings.drawOptions[static_cast<int>(Traits::slot)];
+    }
+
+    addEntry(Traits::kind, obj, &Plotter::updateBounds<typename Traits::BoundsType>, name, addLegend, color, style, drawOption, ownership);
+}
+
+template <typename T>
+void Plotter::SubmitObject(T* obj, const std::string& name, std::uint64_t order, bool addLegend, bool newColor, std::string drawOption, Ownership ownership) {
+    submissions.Push({order, name, [this, obj, name, addLegend, newColor, drawOption, ownership] {
+        AddObject(obj, name, addLegend, newColor, drawOption, ownership);
+    }});
+}
+
+template <typename T>
+Plotter::EntryStyle Plotter::makeStyle(int color) const {
+    using Traits = PlotTraits<T>;
+
+    EntryStyle style;
+    style.lineColor = color;
+    style.lineWidth = settings.lineWidth;
+    style.hasMarkers = Traits::hasMarkers;
+    if constexpr (Traits::hasMarkers) {
+        style.markerColor = InternTransparentColor(color, settings.markerAlpha);
+        style.markerStyle = settings.markerStyle;
+        style.markerSize = settings.markerSize;
+    }
+    style.hasFill = Traits::hasFill;
+    if constexpr (Traits::hasFill) {
+        style.fillColor = InternTransparentColor(color, settings.fillAlpha);
+    }
+    return style;
+}
+
+// Functions are sampled adaptively, and the samples are reused for drawing, bounds and legend placement
+template <>
+void Plotter::updateBounds<TF1>(DrawEntry& entry);
+
 #endif